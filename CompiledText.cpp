@@ -0,0 +1,112 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include <string.h>
+#include "cdefs.h"
+#include "CompiledText.h"
+#include "VectorFont.h"
+
+
+CompiledText::CompiledText (Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered,
+							const LaserSet& straight, const LaserSet& rounded, const VectorFont& font) :
+	start(start),
+	scale_x(scale_x),
+	scale_y(scale_y),
+	centered(centered),
+	straight(&straight),
+	rounded(&rounded),
+	font(&font)
+{
+	setText(text);
+}
+
+CompiledText::~CompiledText()
+{
+	wait_until_unused();
+	delete[] text;
+	delete[] strokes;
+}
+
+void CompiledText::wait_until_unused() const
+{
+	// wait until core1 has drawn the last CMD_DRAW_TEXT for this text.
+	// normally this was in the previous frame and it is long done.
+
+	while (int32(XY2::texts_done - last_drawn) < 0) {}
+}
+
+void CompiledText::setText (cstr new_text)
+{
+	if (text && strcmp(text,new_text) == 0) return;
+
+	wait_until_unused();
+	delete[] text;
+	text = strcpy(new char[strlen(new_text)+1], new_text);
+	compile();
+}
+
+void CompiledText::setPosition (Point new_start)
+{
+	if (start == new_start) return;
+
+	wait_until_unused();
+	start = new_start;
+	compile();
+}
+
+void CompiledText::compile()
+{
+	// compile the text into the stroke list.
+	// this follows print_char() on core1 but stores the points instead of drawing them.
+
+	// count the words needed: a stroke of n points needs 2 + 2*n words:
+	uint size = 1;
+	for (cstr s = text; char c = *s; s++)
+	{
+		const VtGlyph& glyph = font->glyph(c);
+		size += 2 * (glyph.strokes + glyph.points);
+	}
+
+	if (size > capacity)
+	{
+		delete[] strokes;
+		strokes = new Data32[size];
+		capacity = size;
+	}
+
+	Point p0 = start;
+	if (centered) p0.x -= font->printWidth(text) * scale_x / 2;
+
+	Data32* z = strokes;
+	char prev = 0;
+	for (cstr s = text; char c = *s; s++)
+	{
+		const VtGlyph& glyph = font->glyph(c);
+		const int8* p = font->strokes(glyph);
+
+		p0.x += font->kerning(prev,c) * scale_x;	// apply kerning
+		prev = c;									// for next kerning
+
+		while (*p != VT_END)
+		{
+			*z++ = *p++ == VT_STRAIGHT ? straight : rounded;
+			Data32& count = *z++;
+			count = 0u;
+
+			while (*p < VT_END)
+			{
+				*z++ = p0.x + *p++ * scale_x;
+				*z++ = p0.y + *p++ * scale_y;
+				count.u++;
+			}
+		}
+
+		p0.x += glyph.width * scale_x;		// update print position
+	}
+	*z++ = static_cast<const LaserSet*>(nullptr);
+
+	assert(z == strokes + size);
+}
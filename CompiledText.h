@@ -0,0 +1,58 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+#include "XY2.h"
+
+
+// Text compiled into a list of strokes for XY2::drawText().
+//
+// printText() sends every character to core1 which walks the font data for every glyph in every frame.
+// CompiledText does this once on core0, with the position, scale, kerning and LaserSets applied,
+// and core1 draws the strokes from the list which is sent by reference: 2 words in the laser_queue.
+// The glyphs are still transformed with the current transformation on core1.
+//
+// the list is only recompiled if the text or the layout actually changes.
+// before it is modified core0 waits until core1 has finished drawing it.
+//
+// stroke list: n * { LaserSet*, count, count*Point }, nullptr
+
+class CompiledText
+{
+public:
+	CompiledText (Point start, FLOAT scale_x, FLOAT scale_y, cstr text = "", bool centered = false,
+				  const LaserSet& = slow_straight, const LaserSet& = slow_rounded, const VectorFont& = vt_font);
+	~CompiledText();
+
+	CompiledText (const CompiledText&) = delete;
+	CompiledText& operator= (const CompiledText&) = delete;
+
+	void setText (cstr text);
+	void setPosition (Point start);
+	void draw () const { XY2::drawText(*this); }
+	uint scan_cost (Point& pos, const Transformation& t = XY2::transformation0) const { return XY2::costText(pos,*this,t); }
+
+	cstr getText () const { return text; }
+	const Data32* getStrokes () const { return strokes; }
+
+	mutable uint32 last_drawn = 0;	// sequence number of the last CMD_DRAW_TEXT, see XY2::drawText()
+
+private:
+	Point start;
+	FLOAT scale_x, scale_y;
+	bool  centered;
+	const LaserSet* straight;
+	const LaserSet* rounded;
+	const VectorFont* font;
+
+	char*   text = nullptr;
+	Data32* strokes = nullptr;
+	uint    capacity = 0;			// size of strokes[]
+
+	void compile();
+	void wait_until_unused() const;
+};
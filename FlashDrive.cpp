@@ -138,29 +138,336 @@ ErrNo erasePages (uint page, uint num_pages, bool verify)
 }
 
 
-uint findFlashData (uint16 type_idf, uint32* size)
+// ====================================================================
+//		FlashData log
+// ====================================================================
+
+static constexpr uint32 SECTOR_MAGIC = 0x5EC7042Bu;
+static constexpr uint32 NO_SEQ = 0xffffffffu;		// sector erased but not yet in use
+static constexpr uint reserve_sectors = 2;			// free sectors needed for the compaction of a sector
+static constexpr uint gc_threshold = 4;				// gcPending() if less free sectors
+
+struct SectorHeader
+{
+	uint32 magic;
+	uint32 erase_count;
+	uint32 seq;			// programmed when the sector is taken into use
+};
+
+static constexpr uint num_sectors  = log_sectors;
+static constexpr uint first_sector = total_sectors - num_sectors;
+
+static bool   mounted = false;
+static uint   head = 0;				// current sector for writing, 0 … num_sectors-1
+static uint   tail = 0;				// oldest sector in use
+static uint   used_sectors = 0;		// tail … head
+static uint   head_page;			// next free page in head
+static uint32 max_seq = 0;
+static uint   gc_page = 0;			// next page to examine in the tail, 0 = start of the tail
+
+// Ram index of the newest record of each type.
+// built by mount() and updated by append(), so that findFlashData() doesn't scan the uncached Flash.
+// if there are more types than entries, the other types are searched in Flash.
+struct IndexEntry
+{
+	uint16 type;
+	uint   page;
+	uint32 size;
+	uint32 seq;				// of the sector
+};
+static constexpr uint max_index = 16;
+static IndexEntry ram_index[max_index];
+static uint index_count = 0;
+static bool index_overflow = false;
+
+static inline uint sector_page (uint s) { return (first_sector + s) * pages_per_sector; }
+static inline uint num_pages (uint32 size) { return (size + page_mask) / page_size; }
+static inline uint free_sectors () { return num_sectors - used_sectors; }
+
+static inline const SectorHeader* header (uint s)
+{
+	return reinterpret_cast<const SectorHeader*>(start_nocache + sector_page(s) * page_size);
+}
+
+static const FlashData* record_at (uint page, uint end, uint32& size)
+{
+	// return the FlashData at page, if it is valid and fits below end.
+	// size is read only once from Flash: uncached!
+
+	if (page >= end) return nullptr;
+	const FlashData* fd = reinterpret_cast<const FlashData*>(start_nocache + page*page_size);
+	if (fd->fd_magic != FlashData::FD_MAGIC) return nullptr;
+	size = fd->size;
+	if (size-8u > FlashData::MAX_SIZE-8u || page + num_pages(size) > end) return nullptr;
+	return fd;
+}
+
+static bool is_empty_sector (uint s)
+{
+	for (uint i=0; i<pages_per_sector; i++) { if (!isEmptyPage(sector_page(s)+i)) return false; }
+	return true;
+}
+
+static ErrNo write_header (uint s, uint32 erase_count, uint32 seq)
+{
+	// program the header page.
+	// a prepared header of an erased sector is programmed again with the seq:
+	// the other bytes are unchanged and the seq bits only change from 1 to 0.
+
+	char buffer[page_size];
+	memset(buffer,0xff,page_size);
+	SectorHeader h{SECTOR_MAGIC, erase_count, seq};
+	memcpy(buffer,&h,sizeof(h));
+	return writePages(sector_page(s), buffer, page_size);
+}
+
+static ErrNo erase_sector (uint s)
+{
+	const SectorHeader* h = header(s);
+	uint32 erase_count = h->magic == SECTOR_MAGIC ? h->erase_count + 1 : 1;
+
+	ErrNo err = erasePages(sector_page(s));
+	if (err) return err;
+	return write_header(s, erase_count, NO_SEQ);
+}
+
+static bool needs_erase (uint s)
+{
+	// a sector must be erased before it is taken into use,
+	// unless it is prepared by erase_sector() or still empty from the factory.
+
+	const SectorHeader* h = header(s);
+	bool prepared = h->magic == SECTOR_MAGIC && h->seq == NO_SEQ;
+	for (uint i=1; prepared && i<pages_per_sector; i++) { prepared = isEmptyPage(sector_page(s)+i); }
+	return !prepared && !is_empty_sector(s);
+}
+
+static uint next_sector ()
+{
+	return used_sectors ? (head + 1) % num_sectors : head;
+}
+
+static ErrNo activate_next_sector ()
+{
+	// take the next sector after head into use.
+
+	uint s = next_sector();
+	if (used_sectors == num_sectors) return OUT_OF_SPACE;
+
+	if (needs_erase(s))
+	{
+		ErrNo err = erase_sector(s);
+		if (err) return err;
+	}
+
+	ErrNo err = write_header(s, header(s)->magic == SECTOR_MAGIC ? header(s)->erase_count : 0, ++max_seq);
+	if (err) return err;
+
+	head = s;
+	head_page = sector_page(s) + 1;
+	if (used_sectors++ == 0) tail = s;
+	return OK;
+}
+
+static IndexEntry* index_find (uint16 type)
+{
+	for (uint i=0; i<index_count; i++) { if (ram_index[i].type == type) return &ram_index[i]; }
+	return nullptr;
+}
+
+static void index_put (uint16 type, uint page, uint32 size, uint32 seq)
+{
+	IndexEntry* e = index_find(type);
+	if (!e)
+	{
+		if (index_count == max_index) { index_overflow = true; return; }
+		e = &ram_index[index_count++];
+		e->type = type;
+	}
+	e->page = page;
+	e->size = size;
+	e->seq  = seq;
+}
+
+static ErrNo append (const char* data, uint32 size, bool verify)
+{
+	// append a record to the head sector or the next sector
+
+	if (used_sectors == 0 || head_page + num_pages(size) > sector_page(head) + pages_per_sector)
+	{
+		ErrNo err = activate_next_sector();
+		if (err) return err;
+	}
+
+	uint page = head_page;
+	head_page += num_pages(size);
+
+	ErrNo err = writePages(page, data, size, verify);
+	if (err) { head_page = sector_page(head) + pages_per_sector; return err; }	// records after it would not be found
+
+	index_put(reinterpret_cast<const FlashData*>(data)->type, page, size, max_seq);
+	return OK;
+}
+
+static void convert_old_layout ()
 {
-	uint32 data_size;
-	for (uint page = lowestUsedPage(); page <= last_page; page += (data_size+page_mask)/page_size)
+	// FlashData of the old layout was stored downwards from the end of Flash without sector headers.
+	// the newest record of each type is kept in Ram, the sectors are erased and the records are written again.
+
+	uint first = lowestUsedPage();
+	if (first > last_page) return;
+	if (reinterpret_cast<const FlashData*>(start_nocache + first*page_size)->fd_magic != FlashData::FD_MAGIC) return;
+
+	constexpr uint max_records = 8;
+	uint16 types[max_records];
+	char* records[max_records];		// nullptr if the newest record of this type is dropped
+	uint count = 0;
+
+	uint32 size;
+	for (uint page = first; page <= last_page; page += num_pages(size))
 	{
-		cptr a = start_nocache + page*page_size;
-		const FlashData* fd = reinterpret_cast<const FlashData*>(a);
+		const FlashData* fd = reinterpret_cast<const FlashData*>(start_nocache + page*page_size);
+		if (fd->fd_magic != FlashData::FD_MAGIC) break;
+		size = fd->size;
+		if (size-8u > 256*1024u-8u) break;		// old MAX_SIZE
+
+		uint16 type = fd->type;
+		bool seen = false;
+		for (uint i=0; i<count; i++) { seen |= types[i] == type; }
+		if (seen) continue;		// older record
 
-		// data invalid => end of valid data in Flash => return not found:
-		if (fd->fd_magic != FlashData::FD_MAGIC) return 0;		// not found
-		data_size = fd->size; // read only once from Flash: uncached!
-		if (data_size-8u > FlashData::MAX_SIZE-8u) return 0;	// not found
+		if (count == max_records)
+		{
+			printf("flash data: more than %u types in the old layout: the others are dropped\n", max_records);
+			break;
+		}
 
-		if (fd->type == type_idf)
+		types[count] = type;
+		records[count] = nullptr;
+		if (size > FlashData::MAX_SIZE)		// don't keep an older record of this type instead
 		{
-			if (size) *size = data_size;
-			return page;
+			printf("flash data: type 0x%04x: %u bytes is too large for a sector: dropped\n", type, uint(size));
+		}
+		else
+		{
+			records[count] = new char[size];
+			readPages(page, records[count], size);
+		}
+		count++;
+	}
+
+	first &= ~(pages_per_sector-1);
+	erasePages(first, total_pages - first);
+	last_free_page = last_page;
+
+	for (uint i=0; i<count; i++)
+	{
+		if (!records[i]) continue;
+		append(records[i], reinterpret_cast<FlashData*>(records[i])->size, true);
+		delete[] records[i];
+	}
+}
+
+static void mount ()
+{
+	// find the sectors in use: tail = lowest seq, head = highest seq
+
+	mounted = true;
+	used_sectors = 0;
+	max_seq = 0;
+	gc_page = 0;
+	index_count = 0;
+	index_overflow = false;
+
+	if (sector_page(0) < first_page)
+	{
+		// erasePages() and writePages() will refuse to write the log
+		printf("flash data: the program overlaps the log\n");
+		return;
+	}
+
+	uint32 min_seq = NO_SEQ;
+	bool formatted = false;
+
+	for (uint s=0; s<num_sectors; s++)
+	{
+		const SectorHeader* h = header(s);
+		if (h->magic != SECTOR_MAGIC) continue;
+		formatted = true;
+
+		uint32 seq = h->seq;
+		if (seq == NO_SEQ) continue;
+		used_sectors++;
+		if (seq >= max_seq) { max_seq = seq; head = s; }
+		if (seq < min_seq) { min_seq = seq; tail = s; }
+	}
+
+	if (!formatted) { convert_old_layout(); return; }
+
+	// scan the sectors from tail to head and build the index:
+	uint s = tail;
+	for (uint i=0; i<used_sectors; i++, s = (s + 1) % num_sectors)
+	{
+		uint32 seq = header(s)->seq;
+		uint end = sector_page(s) + pages_per_sector;
+		uint page = sector_page(s) + 1;
+
+		uint32 size;
+		while (const FlashData* fd = record_at(page, end, size))
+		{
+			index_put(fd->type, page, size, seq);
+			page += num_pages(size);
+		}
+
+		if (s == head)
+		{
+			head_page = page;
+			if (page < end && !isEmptyPage(page)) head_page = end;	// corrupted: don't write there
+		}
+	}
+}
+
+static uint scan_flash_data (uint16 type_idf, uint32* size)
+{
+	// search the sectors from head to tail, in each sector the last record of this type.
+	// only used if the index overflowed.
+
+	uint s = head;
+	for (uint i=0; i<used_sectors; i++, s = s ? s-1 : num_sectors-1)
+	{
+		uint found = 0;
+		uint32 found_size = 0;
+		uint end = sector_page(s) + pages_per_sector;
+
+		uint32 data_size;
+		for (uint page = sector_page(s) + 1; const FlashData* fd = record_at(page, end, data_size); page += num_pages(data_size))
+		{
+			if (fd->type == type_idf) { found = page; found_size = data_size; }
+		}
+
+		if (found)
+		{
+			if (size) *size = found_size;
+			return found;
 		}
 	}
 
 	return 0; // not found
 }
 
+uint findFlashData (uint16 type_idf, uint32* size)
+{
+	if (!mounted) mount();
+
+	if (const IndexEntry* e = index_find(type_idf))
+	{
+		if (size) *size = e->size;
+		return e->page;
+	}
+
+	return index_overflow ? scan_flash_data(type_idf, size) : 0;
+}
+
 ErrNo readFlashData (FlashData* dest, uint16 type_idf, uint32 size, bool var_size)
 {
 	uint32 actual_size;
@@ -174,14 +481,104 @@ ErrNo readFlashData (FlashData* dest, uint16 type_idf, uint32 size, bool var_siz
 
 ErrNo writeFlashData (const FlashData* source, bool verify)
 {
-	uint page = lowestUsedPage();
-	uint num_pages = (source->size+page_mask)/page_size;
+	if (!mounted) mount();
+	if (source->size > FlashData::MAX_SIZE) return WRONG_SIZE;
+
+	// a new sector must leave reserve_sectors for the garbage collection.
+	// the compaction is not done here: it may need many steps, each with a sector erase.
+	bool new_sector = used_sectors == 0 || head_page + num_pages(source->size) > sector_page(head) + pages_per_sector;
+	if (new_sector && free_sectors() <= reserve_sectors) return OUT_OF_SPACE;
+
+	return append(reinterpret_cast<const char*>(source), source->size, verify);
+}
+
+bool gcPending ()
+{
+	return mounted && used_sectors >= 2 && (gc_page != 0 || free_sectors() < gc_threshold);
+}
+
+static uint next_live_record (uint32& size)
+{
+	// the next record in the tail which gcStep() must copy, or 0 if there are no more live records
+
+	uint end = sector_page(tail) + pages_per_sector;
+	uint page = gc_page ? gc_page : sector_page(tail) + 1;
 
-	if (page-num_pages < first_page) return OUT_OF_SPACE;
-	page -= num_pages;
+	while (const FlashData* fd = record_at(page, end, size))
+	{
+		if (findFlashData(fd->type) == page) return page;	// newest of its type => live
+		page += num_pages(size);
+	}
+	return 0;
+}
 
-	return writePages(page,reinterpret_cast<const char*>(source),source->size,verify);
+bool gcStepErases ()
+{
+	// the next gcStep() erases the tail, or it needs a new sector for the copy which must be erased first:
+
+	if (!mounted) mount();
+	if (used_sectors < 2) return false;
+
+	uint32 size;
+	if (!next_live_record(size)) return true;
+	return head_page + num_pages(size) > sector_page(head) + pages_per_sector && needs_erase(next_sector());
+}
 
+ErrNo gcStep ()
+{
+	// one step of the compaction of the tail sector:
+	// copy the next live record to the head, or erase the tail if there are no more live records.
+	// the head itself is never compacted.
+
+	if (!mounted) mount();
+	if (used_sectors < 2) return OK;
+
+	uint32 size;
+	if (uint page = next_live_record(size))
+	{
+		gc_page = page + num_pages(size);
+
+		char* buffer = new char[size];		// can't program Flash from Flash
+		readPages(page, buffer, size);
+		ErrNo err = append(buffer, size, true);
+		delete[] buffer;
+		return err;
+	}
+
+	// no more live records:
+	uint s = tail;
+	tail = (tail + 1) % num_sectors;
+	used_sectors--;
+	gc_page = 0;
+	return erase_sector(s);
+}
+
+void printFlashDataStats ()
+{
+	if (!mounted) mount();
+
+	uint32 min_erase = NO_SEQ, max_erase = 0;
+	uint64 sum_erase = 0;
+	for (uint s=0; s<num_sectors; s++)
+	{
+		const SectorHeader* h = header(s);
+		uint32 n = h->magic == SECTOR_MAGIC ? h->erase_count : 0;
+		min_erase = min(min_erase, n);
+		max_erase = max(max_erase, n);
+		sum_erase += n;
+	}
+
+	printf("flash data: %u sectors, %u used, %u free, next free page %u\n",
+		   num_sectors, used_sectors, free_sectors(), used_sectors ? head_page - sector_page(head) : 0);
+	printf("erase count: min %u, avg %.1f, max %u\n",
+		   uint(min_erase), double(sum_erase) / num_sectors, uint(max_erase));
+
+	for (uint i=0; i<index_count; i++)
+	{
+		const IndexEntry& e = ram_index[i];
+		printf("type 0x%04x: page %u, size %u, sector seq %u\n", e.type, e.page, uint(e.size), uint(e.seq));
+	}
+	if (index_overflow) printf("more types than index entries\n");
 }
 
 
@@ -41,14 +41,19 @@ namespace Flash
 	static const uint first_page = padded_program_size / page_size;
 	static const uint last_page  = total_pages - 1;
 
+	// FlashData log: a fixed region at the end of Flash which does not depend on the program size,
+	// so that it survives a firmware update with a larger program:
+	static constexpr uint log_sectors = 64;		// 256 kB
+	static_assert(log_sectors < total_sectors, "log_sectors");
+
 
 	enum ErrNo { OK=0, INVALID_PAGE, INVALID_COUNT, FLASH_WRITE_ERROR,
 				 NOT_FOUND, DATA_CORRUPTED, WRONG_SIZE, OUT_OF_SPACE };
 
 
 	extern bool isEmptyPage(uint n);
-	extern uint lowestUsedPage();
-	extern uint topFreePage();
+	extern uint lowestUsedPage();		// old layout
+	extern uint topFreePage();			// old layout
 
 	extern ErrNo readPages  (uint page, char* data, uint bytecount);		// always returns OK
 	extern int comparePages (uint page, const char* data, uint count);		// memcmp(data,flash)
@@ -83,10 +88,24 @@ namespace Flash
 
 
 	// Minimal File System:
-	// FlashData is stored at the end of Flash.
-	// new data is written into space below old data.
-	// each type_idf can only be stored once: the lowest data is it!
-	// TODO: garbage collection
+	// FlashData is stored in a log in the last log_sectors sectors of Flash.
+	// each type_idf can only be stored once: the newest data is it!
+	//
+	// every sector starts with a header page with the erase count and a sequence number,
+	// which is programmed when the sector is taken into use. FlashData records follow and never span sectors.
+	// a new sector is always the next one after the current one, wrapping around at the end of Flash,
+	// so all sectors are erased equally often.
+	// garbage collection: when only a few free sectors are left, the live records of the oldest sector,
+	// which are the newest of their type, are copied into the current sector and the oldest sector is erased.
+	// this is done in steps with gcStep(), e.g. once per frame, so the scanner is never stopped for long.
+	// writeFlashData() never compacts: it returns OUT_OF_SPACE if the write would use one of the last free sectors
+	// which are reserved for the compaction. then the caller should retry after some gcStep()s.
+	//
+	// the mount scans all records once and keeps the newest page of each type in a Ram index,
+	// which is updated with every write: findFlashData() and readFlashData() don't search the Flash.
+	//
+	// the first access mounts the drive. data in the old layout, which was stored downwards from the end of Flash,
+	// is converted: this erases Flash, so the first access must be made while the other core is stopped.
 
 	class FlashData
 	{
@@ -95,7 +114,7 @@ namespace Flash
 
 	public:
 		static constexpr uint16 FD_MAGIC = 0x2BADu;
-		static constexpr uint32 MAX_SIZE = 256*1024;	// 1024 pages
+		static constexpr uint32 MAX_SIZE = (pages_per_sector-1) * page_size;	// 15 pages: must fit in a sector
 
 		bool isValid() const { return fd_magic == FD_MAGIC && (size-8u) <= MAX_SIZE-8u; }
 
@@ -111,9 +130,22 @@ namespace Flash
 	// read FlashData. optionally read less: caller must check dest->size
 	extern ErrNo readFlashData (FlashData* dest, uint16 type_idf, uint32 max_size, bool var_size=false);
 
-	// write FlashData.
+	// write FlashData. returns OUT_OF_SPACE if gcStep() must be called first.
 	extern ErrNo writeFlashData (const FlashData* source, bool verify=true);
 
+	// garbage collection in steps:
+	// each step programs at most one record and erases at most one sector.
+	// a step which only programs takes a few ms, less than a frame.
+	// a step with a sector erase takes ~45 ms, typically, and up to 400 ms: gcStepErases() tells in advance,
+	// so that the caller can do it at a frame boundary with the laser off.
+	// the other core must be stopped by caller if running.
+	extern bool  gcPending ();
+	extern bool  gcStepErases ();
+	extern ErrNo gcStep ();
+
+	// print used and free sectors and the erase counts:
+	extern void printFlashDataStats ();
+
 	template<typename T>
 	ErrNo readFlashData (T* dest, uint16 type_idf)
 	{
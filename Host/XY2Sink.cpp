@@ -0,0 +1,235 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: replacement for XY2.cpp
+// the core0 drawing API maintains the transformation like on the Pico
+// but the drawing commands are not sent to a core1. instead the sink counts the
+// words which would be pushed into the laser_queue and the samples which core1
+// would send to the scanner.
+
+#include "cdefs.h"
+#include "XY2.h"
+#include "XY2Sink.h"
+#include <math.h>
+#include <string.h>
+#include "VectorFont.h"
+#include "CompiledText.h"
+
+
+PIO pio0 = nullptr;
+LaserQueue laser_queue;
+Point XY2::pos0{};
+Transformation XY2::transformation0;
+Transformation XY2::transformation1;
+Transformation XY2::transformation_stack[8];
+uint XY2::transformation_stack_index = 0;
+static constexpr uint transformation_stack_mask = NELEM(XY2::transformation_stack) - 1;
+bool XY2::transform_on_core0 = false;
+uint32 XY2::texts_sent = 0;
+volatile uint32 XY2::texts_done = 0;
+XY2::Lissajous XY2::lissajous;
+
+XY2Stats xy2_stats;
+
+
+// ---- core0 API: count queue words and samples ----
+// the samples are estimated with the same functions which the application can use.
+// the scanner position pos0 is maintained like on core1.
+
+void XY2::moveTo (const Point& p)
+{
+	xy2_stats.queue_words += 1+2;
+	xy2_stats.samples += costMoveTo(pos0, p);
+}
+
+void XY2::drawTo (const Point& p, const LaserSet& set)
+{
+	xy2_stats.queue_words += 1+1+2;
+	xy2_stats.samples += cost_to(pos0, transformation0.transformed(p), set.speed, set.delay_m);
+}
+
+void XY2::drawLine (const Point& p1, const Point& p2, const LaserSet& set)
+{
+	xy2_stats.queue_words += 1+1+4;
+	xy2_stats.samples += costLine(pos0, p1, p2, set);
+}
+
+void XY2::drawRect (const Rect& rect, const LaserSet& set)
+{
+	xy2_stats.queue_words += transform_on_core0 ? 3+4*4 : 1+1+4;
+	xy2_stats.samples += costRect(pos0, rect, set);
+}
+
+void XY2::drawEllipse (const Rect& bbox, FLOAT angle, uint steps, const LaserSet& set)
+{
+	xy2_stats.queue_words += 4 + 2*steps;
+	xy2_stats.samples += costEllipse(pos0, bbox, angle, steps, set);
+}
+
+void XY2::drawPolyLine (uint count, std::function<Point()> nextPoint, const LaserSet& set, PolyLineOptions flags)
+{
+	xy2_stats.queue_words += 4 + 2*count;
+	xy2_stats.samples += costPolyLine(pos0, count, nextPoint, set, flags);
+}
+
+void XY2::drawPolyLine (uint count, const Point points[], const LaserSet& set, PolyLineOptions flags)
+{
+	xy2_stats.queue_words += 4 + 2*count;
+	xy2_stats.samples += costPolyLine(pos0, count, points, set, flags);
+}
+
+void XY2::drawPolygon (uint count, std::function<Point()> nextPoint, const LaserSet& set)
+{
+	drawPolyLine(count,nextPoint,set,POLYLINE_CLOSED);
+}
+
+void XY2::drawPolygon (uint count, const Point points[], const LaserSet& set)
+{
+	drawPolyLine(count,points,set,POLYLINE_CLOSED);
+}
+
+void XY2::drawArc (const Point& center, FLOAT radius_x, FLOAT radius_y, FLOAT angle0, FLOAT sweep, const LaserSet& set)
+{
+	// curves are always transformed by core1:
+	bool f = transform_on_core0;
+	if (f) { send_transformation(); transform_on_core0 = false; }
+
+	xy2_stats.queue_words += 1+1+2+4;
+	xy2_stats.samples += costArc(pos0, center, radius_x, radius_y, angle0, sweep, set);
+
+	if (f) { xy2_stats.queue_words += 1; transform_on_core0 = true; }
+}
+
+void XY2::drawCubic (const Point& p0, const Point& p1, const Point& p2, const Point& p3, const LaserSet& set)
+{
+	bool f = transform_on_core0;
+	if (f) { send_transformation(); transform_on_core0 = false; }
+
+	xy2_stats.queue_words += 1+1+4*2;
+	xy2_stats.samples += costCubic(pos0, p0, p1, p2, p3, set);
+
+	if (f) { xy2_stats.queue_words += 1; transform_on_core0 = true; }
+}
+
+void XY2::drawLissajous (uint count, FLOAT x_scale, FLOAT y_scale, FLOAT x_step,
+						  FLOAT f_ratio_center, FLOAT f_ratio_scale, FLOAT f_ratio_step, const LaserSet& set)
+{
+	// the points are generated here like on core1:
+	bool f = transform_on_core0;
+	if (f) { send_transformation(); transform_on_core0 = false; }
+
+	lissajous.setScales(x_scale, y_scale);
+	lissajous.f_ratio_center = f_ratio_center;
+	lissajous.f_ratio_scale  = f_ratio_scale;
+	lissajous.setSteps(x_step, f_ratio_step);
+
+	xy2_stats.queue_words += 1+1+1+6;
+	xy2_stats.samples += costPolyLine(pos0, count, [](){ return lissajous.next(); }, set, POLYLINE_INFINITE);
+
+	if (f) { xy2_stats.queue_words += 1; transform_on_core0 = true; }
+}
+
+void XY2::printText (Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered,
+					 const LaserSet& straight, const LaserSet& rounded, const VectorFont& font)
+{
+	// glyphs are always transformed by core1:
+	bool f = transform_on_core0;
+	if (f) { send_transformation(); transform_on_core0 = false; }
+
+	xy2_stats.queue_words += 1+3+2+2 + strlen(text)+1;
+	xy2_stats.samples += costText(pos0, start, scale_x, scale_y, text, centered, straight, rounded, font);
+
+	if (f) { xy2_stats.queue_words += 1; transform_on_core0 = true; }
+}
+
+void XY2::drawText (const CompiledText& text)
+{
+	bool f = transform_on_core0;
+	if (f) { send_transformation(); transform_on_core0 = false; }
+
+	xy2_stats.queue_words += 1+1;
+	xy2_stats.samples += costText(pos0, text);
+
+	// there is no core1 which could still draw it:
+	text.last_drawn = ++texts_sent;
+	texts_done = texts_sent;
+
+	if (f) { xy2_stats.queue_words += 1; transform_on_core0 = true; }
+}
+
+
+void XY2::send_transformation ()
+{
+	xy2_stats.queue_words += transformation0.is_projected ? 1+9 : 1+6;
+	transformation1 = transformation0;
+}
+
+void XY2::update_transformation ()
+{
+	if (!transform_on_core0) send_transformation();
+}
+
+void XY2::resetTransformation()
+{
+	transformation0.reset();
+	if (!transform_on_core0) { xy2_stats.queue_words += 1; transformation1.reset(); }
+}
+
+void XY2::setTransformOnCore0 (bool f)
+{
+	if (f == transform_on_core0) return;
+	transform_on_core0 = f;
+
+	if (f) { xy2_stats.queue_words += 1; transformation1.reset(); }
+	else send_transformation();
+}
+
+void XY2::balanceLoad() {}
+
+void XY2::pushTransformation()
+{
+	transformation_stack[--transformation_stack_index & transformation_stack_mask] = transformation0;
+}
+
+void XY2::popTransformation()
+{
+	transformation0 = transformation_stack[transformation_stack_index++ & transformation_stack_mask];
+	update_transformation();
+}
+
+void XY2::setRotation (FLOAT rad)					{ transformation0.setRotation(rad); update_transformation(); }
+void XY2::setScale (FLOAT f)						{ transformation0.setScale(f); update_transformation(); }
+void XY2::setScale (FLOAT fx, FLOAT fy)				{ transformation0.setScale(fx,fy); update_transformation(); }
+void XY2::setOffset (FLOAT dx, FLOAT dy)			{ transformation0.setOffset(dx,dy); update_transformation(); }
+void XY2::setShear (FLOAT sx, FLOAT sy)				{ transformation0.setShear(sx,sy); update_transformation(); }
+void XY2::setProjection (FLOAT px, FLOAT py, FLOAT pz) { transformation0.setProjection(px,py,pz); update_transformation(); }
+void XY2::setRotationAndScale (FLOAT rad, FLOAT fx, FLOAT fy) { transformation0.setRotationAndScale(rad,fx,fy); update_transformation(); }
+void XY2::setTransformation (const Transformation& t) { transformation0 = t; update_transformation(); }
+
+void XY2::setTransformation (FLOAT fx, FLOAT fy, FLOAT sx, FLOAT sy, FLOAT dx, FLOAT dy)
+{
+	new(&transformation0) Transformation(fx,fy,sx,sy,dx,dy);
+	update_transformation();
+}
+
+void XY2::setTransformation (FLOAT fx, FLOAT fy, FLOAT sx, FLOAT sy, FLOAT dx, FLOAT dy, FLOAT px, FLOAT py, FLOAT pz)
+{
+	new(&transformation0) Transformation(fx,fy,sx,sy,dx,dy,px,py,pz);
+	update_transformation();
+}
+
+void XY2::rotate (FLOAT rad)						{ transformation0.rotate(rad); update_transformation(); }
+void XY2::rotateAndScale (FLOAT rad, FLOAT fx, FLOAT fy) { transformation0.rotateAndScale(rad,fx,fy); update_transformation(); }
+void XY2::scale (FLOAT f)							{ transformation0.scale(f); update_transformation(); }
+void XY2::scale (FLOAT fx, FLOAT fy)				{ transformation0.scale(fx,fy); update_transformation(); }
+void XY2::addOffset (FLOAT dx, FLOAT dy)			{ transformation0.addOffset(dx,dy); update_transformation(); }
+void XY2::transform (const Transformation& t)		{ transformation0.addTransformation(t); update_transformation(); }
+
+void XY2::transform (FLOAT fx, FLOAT fy, FLOAT sx, FLOAT sy, FLOAT dx, FLOAT dy)
+{
+	transformation0.addTransformation(fx,fy,sx,sy,dx,dy);
+	update_transformation();
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+
+
+// Host build: statistics of the XY2 sink.
+// the sink counts the words which XY2 would push into the laser_queue
+// and estimates the samples which core1 would send to the scanner.
+
+struct XY2Stats
+{
+	uint64 queue_words = 0;
+	uint64 samples = 0;
+
+	void reset() { queue_words = samples = 0; }
+};
+
+extern XY2Stats xy2_stats;
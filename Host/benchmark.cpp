@@ -0,0 +1,107 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Headless benchmark of the Laseroids game loop.
+//
+//   LaseroidsBenchmark [frames]
+//
+// a scripted player plays the game for the given number of frames (default 10000).
+// the game time advances by the time the scanner would need to draw the frame,
+// as estimated by the XY2 sink, so that the game runs at the speed it would on the Pico.
+// the report lists per level:
+//   the time spent in runOneFrame() on the host,
+//   the words pushed into the laser_queue and the samples sent to the scanner,
+//   the number of asteroids and bullets.
+
+#include "cdefs.h"
+#include "Laseroids.h"
+#include "XY2Sink.h"
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+
+
+static constexpr uint max_levels = 20;
+static constexpr uint32 min_frame_us = 1000;	// scanner frame time if nothing is drawn
+
+struct LevelStats
+{
+	uint   frames = 0;
+	double time_us = 0;
+	uint64 queue_words = 0;
+	uint64 samples = 0;
+	uint64 max_samples = 0;
+	uint64 asteroids = 0;
+	uint   max_asteroids = 0;
+	uint64 bullets = 0;
+};
+
+static LevelStats stats[max_levels];
+
+
+static void play (uint frame)
+{
+	// scripted player: shield always on, shoot and turn at a steady pace
+
+	if (Laseroids::isGameOver()) { laseroids.startNewGame(); return; }
+
+	Laseroids::activateShield();
+	if (frame % 8 == 0) Laseroids::shootCannon();
+	if (frame % 64 < 16) Laseroids::rotateRight();
+	if (frame % 256 == 0) Laseroids::accelerateShip();
+}
+
+
+int main (int argc, char* argv[])
+{
+	uint num_frames = argc > 1 ? uint(atoi(argv[1])) : 10000;
+	if (argc > 2 || num_frames == 0) { fprintf(stderr, "usage: %s [frames]\n", argv[0]); return 2; }
+
+	// the game logs to stdout: silence it and write the report to the original stdout:
+	fflush(stdout);
+	FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+	int devnull = open("/dev/null", O_WRONLY);
+	dup2(devnull, STDOUT_FILENO);
+	close(devnull);
+
+	uint32 now = 0;
+	for (uint frame = 0; frame < num_frames; frame++)
+	{
+		play(frame);
+		xy2_stats.reset();
+
+		auto t0 = std::chrono::steady_clock::now();
+		Laseroids::runOneFrame(now);
+		auto t1 = std::chrono::steady_clock::now();
+
+		LevelStats& s = stats[min(Laseroids::getLevel(), max_levels-1)];
+		s.frames++;
+		s.time_us += std::chrono::duration<double,std::micro>(t1 - t0).count();
+		s.queue_words += xy2_stats.queue_words;
+		s.samples += xy2_stats.samples;
+		s.max_samples = max(s.max_samples, xy2_stats.samples);
+		s.asteroids += Laseroids::getNumAsteroids();
+		s.max_asteroids = max(s.max_asteroids, Laseroids::getNumAsteroids());
+		s.bullets += Laseroids::getNumBullets();
+
+		now += max(min_frame_us, uint32(xy2_stats.samples * 1000000 / XY2_DATA_CLOCK));
+	}
+
+	fflush(stdout);
+	fprintf(report, "%u frames, %.1f sec game time\n\n", num_frames, now * 1e-6);
+	fprintf(report, "level  frames  us/frame  words/frame  samples/frame  max samples  asteroids avg/max  bullets avg\n");
+	for (uint level = 0; level < max_levels; level++)
+	{
+		const LevelStats& s = stats[level];
+		if (s.frames == 0) continue;
+		double n = s.frames;
+		fprintf(report, "%5u  %6u  %8.2f  %11.1f  %13.1f  %11u  %9.1f/%-7u  %11.1f\n",
+				level, s.frames, s.time_us / n, double(s.queue_words) / n, double(s.samples) / n,
+				uint(s.max_samples), double(s.asteroids) / n, s.max_asteroids, double(s.bullets) / n);
+	}
+	fclose(report);
+	return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Test of the fixed point transformations against the float transformations.
+//
+//   LaseroidsFixedTest
+//
+// random transformations are built from values which are exact in Q16.16,
+// so that only the rounding of the fixed point arithmetic is measured and not the rounding of the inputs.
+// then a grid of points in the range ±1000 is transformed with the FixTransformation and the Transformation
+// and the max. distance in scanner units is compared with the tolerance of the operation.
+// returns 1 if any operation exceeds its tolerance.
+
+#include "cdefs.h"
+#include "basic_geometry.h"
+#include <stdio.h>
+
+
+static constexpr uint num_tests = 1000;
+static constexpr int  grid = 1000;		// points in the range ±grid
+
+static uint32 seed = 12345;
+
+static FLOAT random (FLOAT min, FLOAT max)
+{
+	// random value in [min,max] which is exact in Q16.16:
+	seed = seed * 1103515245 + 12345;
+	FLOAT f = min + (max - min) * FLOAT(seed >> 8) / FLOAT(1 << 24);
+	return FLOAT(Fixed(f));
+}
+
+static FLOAT random_sign (FLOAT min, FLOAT max)
+{
+	// random value in [min,max] or [-max,-min]:
+	return seed & 0x100 ? random(min,max) : -random(min,max);
+}
+
+struct TestPair
+{
+	Transformation    t;
+	FixTransformation ft;
+
+	void set (FLOAT fx, FLOAT fy, FLOAT sx, FLOAT sy, FLOAT dx, FLOAT dy)
+	{
+		t.set(fx,fy,sx,sy,dx,dy);
+		ft.set(Fixed(fx),Fixed(fy),Fixed(sx),Fixed(sy),Fixed(dx),Fixed(dy));
+	}
+	void setProjection (FLOAT px, FLOAT py)
+	{
+		t.setProjection(px,py);
+		ft.setProjection(Fixed(px),Fixed(py));
+	}
+	void randomize ()
+	{
+		// scale 0.5 .. 2, shear ±0.3, offset ±500:
+		set(random_sign(0.5f,2), random_sign(0.5f,2), random(-0.3f,0.3f), random(-0.3f,0.3f),
+			random(-500,500), random(-500,500));
+	}
+	void randomize_projection (FLOAT p = 2e-4f)
+	{
+		// q = px*x + py*y + 1 in the range 0.6 .. 1.4 for |x|,|y| ≤ 1000 and p = 2e-4:
+		setProjection(random(-p,p), random(-p,p));
+	}
+
+	FLOAT max_error (const Transformation& pre = Transformation()) const
+	{
+		// max. distance of the transformed grid points.
+		// an inverted transformation is tested with the grid points transformed by the original transformation,
+		// because else some points may be mapped near the horizon of the inverted projection:
+		FLOAT e = 0;
+		for (int y = -grid; y <= grid; y += grid/4)
+		for (int x = -grid; x <= grid; x += grid/4)
+		{
+			Point q = pre.transformed(Point(FLOAT(x),FLOAT(y)));
+			Point p = t.transformed(Point(FLOAT(Fixed(q.x)),FLOAT(Fixed(q.y))));
+			FixPoint fp = ft.transformed(FixPoint(Fixed(q.x),Fixed(q.y)));
+			e = max(e, max(abs(p.x - FLOAT(fp.x)), abs(p.y - FLOAT(fp.y))));
+		}
+		return e;
+	}
+};
+
+static bool report (cstr name, FLOAT error, FLOAT tolerance)
+{
+	bool ok = error <= tolerance;
+	printf("%-32s max. error = %8.4f  tolerance = %6.2f  %s\n", name, double(error), double(tolerance), ok ? "ok" : "FAILED");
+	return ok;
+}
+
+
+int main ()
+{
+	bool ok = true;
+	FLOAT e;
+
+	// the resolution of Q16.16 is 1.5e-5, the coordinates are up to ±1000 and the offsets up to ±500,
+	// so every rounded factor contributes ~0.015 scanner units:
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a, b;
+		a.randomize();
+		b.randomize();
+		a.t.addTransformation(b.t);
+		a.ft.addTransformation(b.ft);
+		e = max(e, a.max_error());
+	}
+	ok &= report("addTransformation", e, 0.1f);
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a;
+		a.randomize();
+		FLOAT rad = random(-4,4);
+		a.t.rotate(rad);
+		a.ft.rotate(Fixed(rad));
+		e = max(e, a.max_error());
+	}
+	ok &= report("rotate", e, 0.1f);
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a;
+		a.randomize();
+		Transformation pre = a.t;
+		a.t.invert();
+		a.ft.invert();
+		e = max(e, a.max_error(pre));
+	}
+	ok &= report("invert", e, 0.5f);
+
+	// the projection divides by q ≥ 0.6. px and py are small and have only a few significant bits
+	// but they are exact in both, so the error is dominated by the division:
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a;
+		a.randomize();
+		a.randomize_projection();
+		e = max(e, a.max_error());
+	}
+	ok &= report("setProjection + transformed", e, 0.2f);
+
+	// b maps the grid to ±2800, so the projection is reduced to keep q in the range 0.44 .. 1.56.
+	// px and py of ~1e-4 are stored * proj_scale in a FixTransformation, else they had only ~3 significant bits:
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a, b;
+		a.randomize();
+		a.randomize_projection(1e-4f);
+		b.randomize();
+		a.t.addTransformation(b.t);
+		a.ft.addTransformation(b.ft);
+		e = max(e, a.max_error());
+	}
+	ok &= report("addTransformation, projected", e, 0.5f);
+
+	// the inverted projection gets px' and py' in the order of 1e-4 from the adjugate matrix:
+
+	e = 0;
+	for (uint i=0; i<num_tests; i++)
+	{
+		TestPair a;
+		a.randomize();
+		a.randomize_projection();
+		Transformation pre = a.t;
+		a.t.invert();
+		a.ft.invert();
+		e = max(e, a.max_error(pre));
+	}
+	ok &= report("invert, projected", e, 0.5f);
+
+	return ok ? 0 : 1;
+}
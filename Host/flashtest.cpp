@@ -0,0 +1,266 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Test of the FlashData log against a simulated NOR Flash.
+//
+//   LaseroidsFlashTest
+//
+// the Flash is mapped at XIP_BASE, the program is faked with __flash_binary_end set by the linker.
+// programming can only clear bits and erasing sets a whole sector to 0xff, as on the real chip.
+// FlashDrive.cpp is included to check the internal state after a remount.
+// returns 1 if any test fails.
+
+#include "../FlashDrive.cpp"
+#include <sys/mman.h>
+
+
+using namespace Flash;
+
+static uint8* const flash = reinterpret_cast<uint8*>(XIP_BASE);
+static uint num_programs = 0;
+static uint num_program_pages = 0;
+static uint num_erases = 0;
+static uint erase_counts[total_sectors];
+
+void flash_range_program (uint32_t offset, const uint8_t* data, size_t count)
+{
+	assert((offset & page_mask) == 0 && (count & page_mask) == 0 && offset + count <= total_size);
+	for (size_t i=0; i<count; i++) { flash[offset+i] &= data[i]; }
+	num_programs++;
+	num_program_pages += count / page_size;
+}
+
+void flash_range_erase (uint32_t offset, size_t count)
+{
+	assert((offset & sector_mask) == 0 && (count & sector_mask) == 0 && offset + count <= total_size);
+	memset(flash+offset, 0xff, count);
+	for (uint s = offset/sector_size; s < (offset+count)/sector_size; s++) { erase_counts[s]++; num_erases++; }
+}
+
+static constexpr uint8 program_byte = 0x55;
+
+// timing of the W25Q16JV, typical: core1 is stopped while the Flash is busy.
+// a gcStep() which doesn't erase must not stop it for longer than a frame:
+static constexpr uint page_program_us = 400;
+static constexpr uint sector_erase_us = 45000;
+static constexpr uint frame_us = 1000000 / 60;
+
+static void format ()
+{
+	// erase the simulated Flash and unmount the drive:
+	memset(flash, 0xff, total_size);
+	memset(flash, program_byte, program_size);
+	memset(erase_counts, 0, sizeof(erase_counts));
+	mounted = false;
+	last_free_page = last_page;
+}
+
+static bool program_intact ()
+{
+	for (uint32 i=0; i<program_size; i++) { if (flash[i] != program_byte) return false; }
+	return true;
+}
+
+static bool report (cstr name, bool ok)
+{
+	printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+
+struct Record : public FlashData
+{
+	uint32 n;
+	char   data[240];
+	Record (uint16 type = 7, uint32 n = 0, char c = 0) : FlashData(type,sizeof(Record)), n(n) { memset(data,c,sizeof(data)); }
+};
+
+struct BigRecord : public FlashData
+{
+	char data[3000];
+	BigRecord (uint16 type = 9, char c = 0) : FlashData(type,sizeof(BigRecord)) { memset(data,c,sizeof(data)); }
+};
+
+struct HugeRecord : public FlashData	// too large for the new layout
+{
+	char data[4000];
+	HugeRecord (uint16 type, char c) : FlashData(type,sizeof(HugeRecord)) { memset(data,c,sizeof(data)); }
+};
+
+template<typename T>
+static uint put_old (uint page, const T& data)
+{
+	// store data like the old layout: below page. returns the new lowest page.
+	page -= num_pages(sizeof(T));
+	memcpy(flash + page*page_size, &data, sizeof(T));
+	return page;
+}
+
+static bool test_old_layout ()
+{
+	// oldest record at the end of Flash, the newest is the lowest:
+	format();
+	uint page = last_page + 1;
+	page = put_old(page, Record(1,1,'a'));
+	page = put_old(page, Record(2,2,'c'));
+	page = put_old(page, Record(3,3,'x'));
+	page = put_old(page, Record(1,4,'b'));
+	page = put_old(page, HugeRecord(3,'X'));		// must not revive Record(3)
+
+	Record r;
+	bool ok = readFlashData(&r,1) == OK && r.n == 4 && r.data[0] == 'b';
+	ok &= readFlashData(&r,2) == OK && r.n == 2 && r.data[0] == 'c';
+	ok &= readFlashData(&r,3) == NOT_FOUND;
+	ok &= used_sectors == 1 && program_intact();
+	for (uint i = first_page; i < sector_page(0); i++) { ok &= isEmptyPage(i); }
+	ok &= report("old layout: newest record per type", ok);
+
+	// more types than can be converted:
+	format();
+	page = last_page + 1;
+	for (uint16 type = 20; type > 10; type--) { page = put_old(page, Record(type,type)); }
+
+	uint count = 0;
+	for (uint16 type = 11; type <= 20; type++) { count += readFlashData(&r,type) == OK && r.n == type; }
+	return report("old layout: max. 8 types", ok & (count == 8) & program_intact());
+}
+
+static bool test_no_compaction_in_write ()
+{
+	// writeFlashData() must not erase: it returns OUT_OF_SPACE before it uses the reserve.
+	// the log is used once, so that all sectors are prepared and activating a sector needs no erase.
+
+	format();
+	ErrNo err = OK;
+	Record r;
+	while (err == OK && max_seq <= num_sectors)
+	{
+		r.n++;
+		err = writeFlashData(&r);
+		while (err == OK && gcPending()) { err = gcStep(); }
+	}
+
+	uint erases = num_erases;
+	while (err == OK) { r.n++; err = writeFlashData(&r); }
+
+	bool ok = err == OUT_OF_SPACE && num_erases == erases && free_sectors() == reserve_sectors && gcPending();
+	ok &= report("write returns OUT_OF_SPACE, no erase", ok);
+
+	while (ok && gcPending()) { ok = gcStep() == OK; }
+	uint32 n = ++r.n;
+	ok &= writeFlashData(&r) == OK;
+	ok &= readFlashData(&r,7) == OK && r.n == n;
+	return report("write after the garbage collection", ok);
+}
+
+static bool test_wear_leveling ()
+{
+	// many writes with one gcStep() per frame, with a remount from time to time,
+	// as it happens when the device is switched off.
+
+	format();
+	BigRecord big(9,'x');
+	bool ok = writeFlashData(&big) == OK;
+	bool step_ok = true;
+	bool predict_ok = true;
+	bool remount_ok = true;
+	uint deferred = 0;
+	uint max_copy_us = 0;
+	uint gc_steps = 0, erase_steps = 0;
+
+	for (uint32 i=1; i<=30000 && ok; i++)
+	{
+		Record r7(7,i), r8(8,i);
+		ErrNo err = writeFlashData(&r7);
+		if (err == OUT_OF_SPACE)	// as main.cpp does: retry after the garbage collection
+		{
+			deferred++;
+			while (gcPending()) { gcStep(); }
+			err = writeFlashData(&r7);
+		}
+		if (i % 3 == 0 && err == OK) err = writeFlashData(&r8);
+		ok &= err == OK;
+
+		if (gcPending())
+		{
+			bool erase_predicted = gcStepErases();
+			uint erases = num_erases;
+			uint programs = num_programs;
+			uint pages = num_program_pages;
+			ok &= gcStep() == OK;
+			erases = num_erases - erases;
+			pages = num_program_pages - pages;
+			step_ok &= erases <= 1 && num_programs - programs <= 3;
+			predict_ok &= erase_predicted == (erases != 0);
+			if (!erases) max_copy_us = max(max_copy_us, pages * page_program_us);
+			gc_steps++;
+			erase_steps += erases;
+		}
+
+		Record r;
+		ok &= readFlashData(&r,7) == OK && r.n == i;
+
+		if (i % 777 == 0)
+		{
+			// remount, possibly in the middle of the compaction of a sector:
+			uint h = head, t = tail, u = used_sectors, hp = head_page, ic = index_count;
+			uint32 ms = max_seq;
+			IndexEntry idx[max_index];
+			memcpy(idx, ram_index, sizeof(idx));
+			mount();
+			remount_ok &= h == head && t == tail && u == used_sectors && hp == head_page && ms == max_seq;
+			remount_ok &= ic == index_count;
+			for (uint j=0; j<ic; j++)	// the order of the entries may differ
+			{
+				const IndexEntry* e = index_find(idx[j].type);
+				remount_ok &= e && e->page == idx[j].page && e->size == idx[j].size && e->seq == idx[j].seq;
+			}
+		}
+	}
+
+	Record r;
+	BigRecord b;
+	ok &= readFlashData(&r,8) == OK && r.n == 30000;
+	ok &= readFlashData(&b,9) == OK && b.data[0] == 'x' && b.data[2999] == 'x';
+	ok = report("30000 writes, read back", ok);
+	ok &= report("gcStep(): max. 1 erase", step_ok);
+	ok &= report("gcStepErases() predicts every erase", predict_ok);
+	printf("  %u gc steps, %u with an erase of %u ms, max. %u.%u ms without erase\n",
+		   gc_steps, erase_steps, sector_erase_us / 1000, max_copy_us / 1000, max_copy_us / 100 % 10);
+	ok &= report("gcStep() without erase: max. 1 frame", max_copy_us <= frame_us);
+	ok &= report("remount restores the state", remount_ok);
+	printf("  %u writes deferred for the garbage collection\n", deferred);
+
+	uint min_erase = ~0u, max_erase = 0, outside = 0;
+	for (uint s=0; s<total_sectors; s++)
+	{
+		if (s < first_sector) { outside += erase_counts[s]; continue; }
+		min_erase = min(min_erase, erase_counts[s]);
+		max_erase = max(max_erase, erase_counts[s]);
+	}
+	printf("  erase counts %u .. %u\n", min_erase, max_erase);
+	ok &= report("erase counts within 1", max_erase - min_erase <= 1);
+	ok &= report("nothing erased outside the log", outside == 0 && program_intact());
+	return ok;
+}
+
+
+int main ()
+{
+	if (mmap(flash, total_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0) != flash)
+	{
+		printf("can't map the simulated Flash at 0x%08x\n", XIP_BASE);
+		return 1;
+	}
+
+	printf("program: %u kB, log: %u sectors at 0x%08x\n",
+		   uint(program_size / 1024), num_sectors, uint(first_sector * sector_size));
+
+	bool ok = test_old_layout();
+	ok &= test_no_compaction_in_write();
+	ok &= test_wear_leveling();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Test of VectorFont::load() with valid and corrupted font blobs.
+//
+//   LaseroidsFontTest
+//
+// the blobs are copies of the compiled-in fonts, as they would be written to flash.
+// every font accepted by load() is printed like print_char() and CompiledText::compile() do,
+// and no read must go outside of the stroke data.
+// returns 1 if any test fails.
+
+#include "cdefs.h"
+#include "VectorFont.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+class Blob
+{
+public:
+	std::vector<uint32> words;	// aligned like the font in flash
+	uint size;
+
+	Blob (const VectorFont& font) : words((font.size() + 3) / 4), size(font.size())
+	{
+		memcpy(words.data(), &font, size);
+	}
+
+	VectorFont& font () { return *reinterpret_cast<VectorFont*>(words.data()); }
+	VtGlyph& glyph (uint i) { return const_cast<VtGlyph&>(font().glyphs()[i]); }
+	int8* data () { return const_cast<int8*>(font().data()); }
+	VtKerning* kernings () { return const_cast<VtKerning*>(font().kernings()); }
+	const VectorFont* load () { return VectorFont::load(words.data(), size); }
+};
+
+static bool print_all (const VectorFont& font)
+{
+	// walk all glyphs like print_char() and count the words like CompiledText::compile().
+	// returns false if a byte outside of data[] would be read or the count is wrong.
+
+	const int8* data = font.data();
+	const uint data_size = font.data_size;
+
+	for (uint c = 0; c < 256; c++)
+	{
+		const VtGlyph& glyph = font.glyph(char(c));
+		uint i = glyph.index;
+		uint words = 0;
+
+		for (;;)
+		{
+			if (i >= data_size) return false;
+			if (data[i] == VT_END) break;
+			i++;						// line type
+			words += 2;
+			if (i + 2 > data_size) return false;
+			i += 2;						// move_to()
+			words += 2;
+			for (;;)
+			{
+				if (i >= data_size) return false;
+				if (data[i] >= VT_END) break;
+				if (i + 2 > data_size) return false;
+				i += 2;					// draw_to()
+				words += 2;
+			}
+		}
+
+		if (words != 2u * (glyph.strokes + glyph.points)) return false;
+	}
+	return true;
+}
+
+static bool report (cstr name, bool ok)
+{
+	printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+static uint32 seed = 12345;
+
+static uint random (uint n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) % n;
+}
+
+
+int main ()
+{
+	bool ok = true;
+
+	// the compiled-in fonts:
+	ok &= report("vt_font in place", VectorFont::load(&vt_font, vt_font.size()) == &vt_font && print_all(vt_font));
+	ok &= report("vt_thin_font in place", VectorFont::load(&vt_thin_font, vt_thin_font.size()) == &vt_thin_font);
+
+	{
+		Blob b(vt_thin_font);
+		ok &= report("copy of vt_thin_font", b.load() == &b.font() && print_all(b.font()));
+	}
+
+	// corrupted blobs:
+	{
+		Blob b(vt_font);
+		ok &= report("unaligned", VectorFont::load(reinterpret_cast<char*>(b.words.data()) + 1, b.size - 1) == nullptr);
+	}
+	{
+		Blob b(vt_font);
+		b.font().magic ^= 1;
+		ok &= report("wrong magic", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_thin_font);
+		b.size -= 1;
+		ok &= report("truncated", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_thin_font);
+		b.font().num_kerning += 1;
+		ok &= report("num_kerning too large", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_thin_font);
+		std::swap(b.kernings()[0], b.kernings()[1]);
+		ok &= report("kerning pairs not sorted", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_thin_font);
+		b.kernings()[1] = b.kernings()[0];
+		ok &= report("kerning pair twice", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_font);
+		b.font().default_char = uint8(b.font().first_char - 1);
+		ok &= report("default_char not in font", b.load() == nullptr);
+	}
+	{
+		Blob b(vt_font);
+		b.glyph(10).index = b.font().data_size;
+		ok &= report("glyph index out of data", b.load() == nullptr);
+	}
+	{
+		// the VT_END of the last glyph and the padding after it replaced by coordinates:
+		// the walk would run past data_size.
+		Blob b(vt_thin_font);
+		uint i = b.glyph(b.font().num_glyphs - 1).index + 3;
+		while (b.data()[i] != VT_END) i++;
+		while (i < b.font().data_size) b.data()[i++] = 0;
+		ok &= report("stroke runs past data_size", b.load() == nullptr);
+	}
+	{
+		// a VT_END on the y coordinate of 'A': print_char() would read it as a coordinate.
+		Blob b(vt_thin_font);
+		b.data()[b.font().glyph('A').index + 2] = VT_END;
+		ok &= report("VT_END on a coordinate", b.load() == nullptr);
+	}
+	{
+		// a line type code on the y coordinate of the 2nd point of 'A':
+		Blob b(vt_thin_font);
+		b.data()[b.font().glyph('A').index + 4] = VT_ROUNDED;
+		ok &= report("line type on a coordinate", b.load() == nullptr);
+	}
+	{
+		// wrong number of points: CompiledText would allocate too few words.
+		Blob b(vt_font);
+		b.glyph('W' - ' ').points -= 1;
+		ok &= report("wrong number of points", b.load() == nullptr);
+	}
+
+	// random corruptions: load() may accept them, but then the walk must stay inside data[]:
+	uint accepted = 0;
+	bool walk_ok = true;
+	for (uint n = 0; n < 20000; n++)
+	{
+		Blob b(vt_thin_font);
+		uint8* bytes = reinterpret_cast<uint8*>(b.words.data());
+		for (uint k = 1 + random(3); k--; ) { bytes[random(b.size)] = uint8(random(256)); }
+		if (b.load() == nullptr) continue;
+		accepted++;
+		walk_ok &= print_all(b.font());
+	}
+	printf("  %u of 20000 random corruptions accepted\n", accepted);
+	ok &= report("random corruptions: walk inside data", walk_ok);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+// the Flash is simulated by the application, which must map it at XIP_BASE.
+// there is no cache on the host: the uncached alias is the same memory.
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_PAGE_SIZE   256u
+#define FLASH_SECTOR_SIZE 4096u
+
+#define XIP_BASE                 0x10000000u
+#define XIP_NOCACHE_NOALLOC_BASE XIP_BASE
+#define PICO_FLASH_SIZE_BYTES    (2u * 1024 * 1024)
+
+extern void flash_range_program (uint32_t flash_offs, const uint8_t* data, size_t count);
+extern void flash_range_erase (uint32_t flash_offs, size_t count);
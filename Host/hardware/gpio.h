@@ -0,0 +1,12 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+// there are no LEDs on the host.
+
+#pragma once
+
+static inline void gpio_put (unsigned /*gpio*/, bool /*value*/) {}
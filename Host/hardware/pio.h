@@ -0,0 +1,21 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+// declarations for the inline functions in XY2.h which run on core1 only.
+// they are never called on the host.
+
+#pragma once
+#include <stdint.h>
+#include "hardware/gpio.h"
+
+typedef struct pio_hw* PIO;
+extern PIO pio0;
+
+extern unsigned pio_sm_get_tx_fifo_level (PIO, unsigned sm);
+extern bool pio_sm_is_tx_fifo_full (PIO, unsigned sm);
+extern bool pio_sm_is_tx_fifo_empty (PIO, unsigned sm);
+extern void pio_sm_put (PIO, unsigned sm, uint32_t data);
@@ -0,0 +1,16 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+static inline void __dmb() { std::atomic_thread_fence(std::memory_order_seq_cst); }
+
+static inline uint32_t save_and_disable_interrupts() { return 0; }
+static inline void restore_interrupts(uint32_t) {}
@@ -0,0 +1,14 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+// time_us_32() returns a virtual clock which is advanced by the application.
+
+#pragma once
+#include <stdint.h>
+
+extern uint32_t host_time_us;
+static inline uint32_t time_us_32() { return host_time_us; }
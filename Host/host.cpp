@@ -0,0 +1,20 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: replacements for the Pico SDK
+
+#include "cdefs.h"
+#include "hardware/timer.h"
+
+
+uint32 host_time_us = 0;	// virtual clock for time_us_32()
+
+
+void handle_assert (cstr file, uint line) noexcept
+{
+	fprintf(stderr, "%s:%u: assertion failed\n", file, line);
+	abort();
+}
@@ -0,0 +1,19 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Micro benchmarks of the math kernels on the host, see MathBenchmark.h
+//
+//   LaseroidsMathBench
+
+#include "cdefs.h"
+#include "MathBenchmark.h"
+
+
+int main ()
+{
+	runMathBenchmarks();
+	return 0;
+}
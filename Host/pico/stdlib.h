@@ -0,0 +1,31 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Host build: minimal replacement for the Pico SDK header.
+// only what is needed by the game logic.
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <utility>
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+
+typedef struct
+{
+	int16_t year;
+	int8_t month, day, dotw, hour, min, sec;
+} datetime_t;
+
+static inline unsigned get_core_num() { return 0; }
+
+#define __not_in_flash_func(F) F
+#define __no_inline_not_in_flash_func(F) F
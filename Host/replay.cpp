@@ -0,0 +1,89 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Replay a recorded Laseroids game on the host.
+//
+//   LaseroidsReplay <logfile>
+//
+// the logfile is the stdout of the Pico after selecting '8' in the main menu.
+// the game is recorded again while it is replayed:
+// the replay is exact if both recordings are identical, including the end marker with the final score.
+// a truncated recording, which hit the capacity of the Recorder, can be replayed but not verified.
+
+#include "cdefs.h"
+#include "Laseroids.h"
+#include "Recorder.h"
+
+
+static Recorder recording;
+
+
+int main (int argc, char* argv[])
+{
+	if (argc != 2) { fprintf(stderr, "usage: %s <logfile>\n", argv[0]); return 2; }
+
+	FILE* file = fopen(argv[1], "r");
+	if (!file) { fprintf(stderr, "%s: file not found\n", argv[1]); return 2; }
+	bool ok = recording.read(file);
+	fclose(file);
+	if (!ok) { fprintf(stderr, "%s: no recording found\n", argv[1]); return 2; }
+
+	bool complete = recording.isComplete();
+	if (!complete) fprintf(stderr, "warning: the recording is truncated, it can't be verified\n");
+
+	uint frames = 0;
+	uint32 now = 0;
+	uint recorded_score = 0;
+
+	for (uint i=0; i<recording.count; i++)
+	{
+		uint32 word  = recording.data[i];
+		uint32 value = word & Recorder::VALUE_MASK;
+
+		switch (word & Recorder::TAG_MASK)
+		{
+		case Recorder::TAG_START:
+			if (++i == recording.count) break;
+			now = recording.data[i];
+			laseroids.startNewGame();
+			Laseroids::runOneFrame(now);
+			frames++;
+			break;
+		case Recorder::TAG_INPUT:
+			Laseroids::handleInput(Laseroids::Input(value));
+			break;
+		case Recorder::TAG_FRAME:
+			now += value;
+			Laseroids::runOneFrame(now);
+			frames++;
+			break;
+		case Recorder::TAG_END:
+			printf("recorded score: %u\n", value);
+			recorded_score = value;
+			break;
+		default:
+			fprintf(stderr, "word %u: invalid tag: 0x%08x\n", i, uint(word));
+			return 1;
+		}
+	}
+
+	printf("replayed %u frames, score: %u, playtime: %.1f sec\n",
+		   frames, Laseroids::getScore(), double(Laseroids::getPlaytime()));
+
+	uint n = min(recording.count, recorder.count);
+	uint i = 0;
+	while (i < n && recording.data[i] == recorder.data[i]) { i++; }
+	if (i == recording.count && i == recorder.count)
+	{
+		if (!complete) { printf("replay matches the truncated recording\n"); return 1; }
+		if (Laseroids::getScore() != recorded_score) { printf("replay score differs from recorded score\n"); return 1; }
+		printf("replay is exact\n");
+		return 0;
+	}
+
+	printf("replay diverged at word %u of %u\n", i, recording.count);
+	return 1;
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+// Decode the trace log of Laseroids.
+//
+//   LaseroidsTrace [--json] <logfile>
+//
+// the logfile is the stdout of the Pico after selecting '7' in the main menu twice: the log is printed when tracing stops.
+// the events are printed as text or, with --json, in the Chrome trace event format
+// with one timeline per core. load it in chrome://tracing or https://ui.perfetto.dev.
+
+#include "cdefs.h"
+#include "Trace.h"
+#include <vector>
+
+
+struct Event
+{
+	uint64 time;		// unwrapped time_us_32()
+	TraceEvent e;
+};
+
+static std::vector<Event> events;
+
+
+static bool read_log (FILE* file)
+{
+	// read all events and unwrap the 32 bit timestamps for each core
+
+	uint64 base[2] = {0,0};
+	uint32 last[2] = {0,0};
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		TraceEvent e;
+		if (!trace_parse(line, e)) continue;
+
+		uint core = e.core & 1;
+		if (e.time < last[core] && last[core] - e.time > 0x80000000u) base[core] += 0x100000000ull;
+		last[core] = e.time;
+
+		events.push_back(Event{base[core] + e.time, e});
+	}
+	return events.size() != 0;
+}
+
+static cstr name4 (uint32 n, char buffer[5])
+{
+	for (uint i=0; i<4; i++) { buffer[i] = char(n >> (8*i)); }
+	buffer[4] = 0;
+	return buffer;
+}
+
+static void print_text ()
+{
+	uint64 t0 = events[0].time;
+	for (const Event& ev : events) { t0 = min(t0, ev.time); }
+
+	for (const Event& ev : events)
+	{
+		const TraceEvent& e = ev.e;
+		printf("%12.3f ms  core%u  %-14s", double(ev.time - t0) * 1e-3, uint(e.core), trace_id_name(e.id));
+
+		char buffer[5];
+		switch (e.id)
+		{
+		case TRACE_SIMULATE_BEGIN:
+		case TRACE_DRAW_BEGIN:		break;
+		case TRACE_LOST:			printf("  %u events", uint(e.a)); break;
+		case TRACE_SIMULATE_END:	printf("  %u steps", uint(e.a)); break;
+		case TRACE_DRAW_END:		printf("  detail %u", uint(e.a)); break;
+		case TRACE_OPTIMIZE:		printf("  %u swaps", uint(e.a)); break;
+		case TRACE_CORE0_WAIT:
+		case TRACE_CORE1_WAIT:		printf("  %u us", uint(e.a)); break;
+		case TRACE_NEW_OBJECT:
+		case TRACE_DELETE_OBJECT:	printf("  %s 0x%08x", name4(e.a,buffer), uint(e.b)); break;
+		default:					printf("  0x%08x 0x%08x", uint(e.a), uint(e.b)); break;
+		}
+		printf("\n");
+	}
+}
+
+static void print_json ()
+{
+	// Chrome trace event format:
+	// begin/end pairs for simulation and drawing, complete events for waits, instant events else
+
+	uint64 t0 = events[0].time;
+	for (const Event& ev : events) { t0 = min(t0, ev.time); }
+
+	printf("{\"traceEvents\":[\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"core0\"}},\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"core1\"}}");
+
+	for (const Event& ev : events)
+	{
+		const TraceEvent& e = ev.e;
+		unsigned long long ts = ev.time - t0;	// for %llu
+		char buffer[5];
+
+		printf(",\n{\"pid\":1,\"tid\":%u,", uint(e.core));
+		switch (e.id)
+		{
+		case TRACE_SIMULATE_BEGIN: printf("\"name\":\"simulate\",\"ph\":\"B\",\"ts\":%llu}", ts); break;
+		case TRACE_SIMULATE_END:   printf("\"name\":\"simulate\",\"ph\":\"E\",\"ts\":%llu,\"args\":{\"steps\":%u}}", ts, uint(e.a)); break;
+		case TRACE_DRAW_BEGIN:	   printf("\"name\":\"draw\",\"ph\":\"B\",\"ts\":%llu}", ts); break;
+		case TRACE_DRAW_END:	   printf("\"name\":\"draw\",\"ph\":\"E\",\"ts\":%llu,\"args\":{\"detail\":%u}}", ts, uint(e.a)); break;
+		case TRACE_CORE0_WAIT:
+		case TRACE_CORE1_WAIT:
+			printf("\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u}", trace_id_name(e.id), ts - min(ts, (unsigned long long)e.a), uint(e.a));
+			break;
+		case TRACE_NEW_OBJECT:
+		case TRACE_DELETE_OBJECT:
+			printf("\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"args\":{\"object\":\"%s\",\"address\":%u}}",
+				   trace_id_name(e.id), ts, name4(e.a,buffer), uint(e.b));
+			break;
+		default:
+			printf("\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"args\":{\"a\":%u,\"b\":%u}}",
+				   trace_id_name(e.id), ts, uint(e.a), uint(e.b));
+			break;
+		}
+	}
+	printf("\n]}\n");
+}
+
+
+int main (int argc, char* argv[])
+{
+	bool json = argc == 3 && strcmp(argv[1], "--json") == 0;
+	if (argc != 2 && !json) { fprintf(stderr, "usage: %s [--json] <logfile>\n", argv[0]); return 2; }
+
+	cstr filename = argv[argc-1];
+	FILE* file = fopen(filename, "r");
+	if (!file) { fprintf(stderr, "%s: file not found\n", filename); return 2; }
+	bool ok = read_log(file);
+	fclose(file);
+	if (!ok) { fprintf(stderr, "%s: no trace events found\n", filename); return 2; }
+
+	if (json) print_json(); else print_text();
+	return 0;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "cdefs.h"
+#include "XY2.h"
+
+
+// application defined parameter sets, set 0 is used for jump
+#define FAST SCANNER_MAX_SPEED
+#define SLOW SCANNER_MAX_SPEED*2/3
+LaserSet laser_set[8] =
+{
+	#define A LASER_ON_DELAY
+	#define E LASER_OFF_DELAY
+	#define M LASER_MIDDLE_DELAY
+	#define J LASER_JUMP_DELAY
+
+	LaserSet{.speed=FAST, .pattern=0x003, .delay_a=0, .delay_m=0, .delay_e=J},	// jump
+	LaserSet{.speed=FAST, .pattern=0x3FF, .delay_a=A, .delay_m=M, .delay_e=E},	// fast straight
+	LaserSet{.speed=SLOW, .pattern=0x3FF, .delay_a=A, .delay_m=M, .delay_e=E},	// slow straight
+	LaserSet{.speed=FAST, .pattern=0x3FF, .delay_a=A, .delay_m=0, .delay_e=E},	// fast rounded
+	LaserSet{.speed=SLOW, .pattern=0x3FF, .delay_a=A, .delay_m=0, .delay_e=E},	// slow rounded
+
+	#undef E
+	#undef A
+	#undef M
+	#undef J
+};
@@ -7,8 +7,11 @@
 #include "utilities.h"
 #include <math.h>
 #include "cdefs.h"
+#include "fast_trig.h"
 #include "Laseroids.h"
 #include "XY2.h"
+#include "Recorder.h"
+#include "Trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include "pico/stdlib.h"
@@ -38,6 +41,9 @@ static constexpr FLOAT BULLET_SPEED = SIZE/BULLET_LIFETIME * FLOAT(0.7);
 static constexpr FLOAT BULLET_LENGTH = FLOAT(0.9);
 static constexpr FLOAT SHIELD_RADIANS = 4;
 
+// the simulation runs in fixed time steps, independent of the frame rate:
+static constexpr FLOAT TIME_STEP = FLOAT(1.0/120);
+
 
 
 
@@ -45,10 +51,11 @@ static constexpr FLOAT SHIELD_RADIANS = 4;
 static DisplayList display_list;
 static Lifes* lifes = nullptr;
 static Score* score = nullptr;
+static Particles* particles = nullptr;
 Player* player = nullptr;
 static Alien* alien = nullptr;
-static uint num_asteroids = 0;
-static uint num_bullets = 0;
+static Asteroids asteroids;
+static Bullets bullets;
 static uint32 time_last_run_us;
 static uint32 time_start_of_game_us;
 static uint level;
@@ -56,6 +63,23 @@ static uint level;
 Laseroids::State Laseroids::state = Laseroids::IDLE;
 static FLOAT state_countdown;
 
+// time not yet simulated, less than TIME_STEP after move_all():
+static FLOAT time_accumulated = 0;
+
+// objects are drawn at their position this time before the last step
+// => interpolated between the last two steps:
+static FLOAT draw_lag = 0;
+
+// counts the calls to move_all(), used to validate cached world-space polygons:
+static uint sim_step = 0;
+
+// level of detail for draw(): 0 = full detail
+// selected per frame so that the estimated scan time stays below MAX_FRAME_SAMPLES:
+static constexpr uint NUM_DETAIL_LEVELS = 3;
+static constexpr uint MAX_FRAME_SAMPLES = XY2_DATA_CLOCK / 15;	// keep refresh rate above 15 Hz
+static uint detail = 0;
+static uint particle_samples = 0;	// samples left for the particles in this frame
+
 
 
 // =====================================================================
@@ -87,6 +111,86 @@ static inline FLOAT dist (const IObject* o1, const IObject* o2)
 	return dist(o1->last_point(),o2->first_point());
 }
 
+static inline FLOAT edge_function (const Point& p1, const Point& p2, const Point& pt)
+{
+	// > 0 if pt is left of line from p1 to p2
+	// < 0 if pt is right of line from p1 to p2
+
+	return (p2.x-p1.x) * (pt.y-p1.y) - (p2.y-p1.y) * (pt.x-p1.x);
+}
+
+static inline bool is_right_of (const Point& p1, const Point& p2, const Point& pt)
+{
+	// test whether pt is right of line from p1 to p2
+
+	return edge_function(p1,p2,pt) < 0;
+}
+
+static bool is_inside (uint count, const Point polygon[], const Point& pt)
+{
+	// test whether pt is inside the closed polygon
+	// winding number test: works for concave polygons and for both orientations
+
+	int winding = 0;
+	const Point* p1 = &polygon[count-1];
+	for (uint i=0; i<count; i++)
+	{
+		const Point* p2 = &polygon[i];
+		if (p1->y <= pt.y)
+		{
+			if (p2->y > pt.y && edge_function(*p1,*p2,pt) > 0) winding++;	// upward crossing
+		}
+		else
+		{
+			if (p2->y <= pt.y && edge_function(*p1,*p2,pt) < 0) winding--;	// downward crossing
+		}
+		p1 = p2;
+	}
+	return winding != 0;
+}
+
+static bool segment_hits_circle (const Point& a, const Point& b, const Point& center, FLOAT r)
+{
+	// test whether the line from a to b touches the circle
+
+	Dist ab = b - a;
+	Dist ac = center - a;
+	FLOAT len2 = ab.dx*ab.dx + ab.dy*ab.dy;
+	FLOAT t = len2 > 0 ? minmax(FLOAT(0), (ac.dx*ab.dx + ac.dy*ab.dy) / len2, FLOAT(1)) : 0;
+	Dist d = ac - ab * t;		// from nearest point on the line to the center
+	return d.dx*d.dx + d.dy*d.dy <= r*r;
+}
+
+static bool segment_hits_polygon (uint count, const Point polygon[], const Point& a, const Point& b, Point& entry)
+{
+	// test whether the line from a to b touches the closed polygon
+	// and return the first point of contact in entry
+
+	if (is_inside(count,polygon,a)) { entry = a; return true; }
+
+	Dist  r = b - a;
+	FLOAT tmin = 2;
+	const Point* p1 = &polygon[count-1];
+	for (uint i=0; i<count; i++)
+	{
+		const Point* p2 = &polygon[i];
+		Dist  s = *p2 - *p1;
+		Dist  q = *p1 - a;
+		FLOAT d = r.dx*s.dy - r.dy*s.dx;
+		if (d != 0)
+		{
+			FLOAT t = (q.dx*s.dy - q.dy*s.dx) / d;		// position on a-b
+			FLOAT u = (q.dx*r.dy - q.dy*r.dx) / d;		// position on p1-p2
+			if (t >= 0 && t <= 1 && u >= 0 && u <= 1 && t < tmin) tmin = t;
+		}
+		p1 = p2;
+	}
+
+	if (tmin > 1) return false;
+	entry = a + r * tmin;
+	return true;
+}
+
 IObject* DisplayList::best_insertion_point (IObject* new_o)
 {
 	IObject* o = root;
@@ -246,23 +350,65 @@ uint DisplayList::optimize()
 	}
 	while ((o=o->_next) != root);
 
-	if (cnt) printf("optimize(): swaps: %u\n",cnt);
+	if (cnt) TRACE(TRACE_OPTIMIZE, cnt);
 	return cnt;
 }
 
 
+// =====================================================================
+//						LEVEL OF DETAIL
+// =====================================================================
+
+// the objects estimate the samples needed to draw them with scan_cost(pos,detail)
+// using the scan time estimation of XY2. pos is the scanner position after the previous object.
+
+static uint frame_cost (uint detail)
+{
+	// estimated samples for drawing all objects incl. the jumps between them
+
+	uint cost = 0;
+	Point pos;
+	for (IObject* o = display_list.first(); o; o = display_list.next())
+	{
+		cost += o->scan_cost(pos,detail);
+	}
+	return cost;
+}
+
+void Laseroids::select_detail()
+{
+	// keep the detail of the last frame if the frame fits into MAX_FRAME_SAMPLES
+	// else reduce the detail until it fits.
+	// every 8th frame test whether the next higher detail fits with some headroom.
+
+	static uint frame = 0;
+	bool try_higher = ++frame % 8 == 0;
+
+	uint cost = frame_cost(detail);
+	while (cost > MAX_FRAME_SAMPLES && detail < NUM_DETAIL_LEVELS-1)
+	{
+		cost = frame_cost(++detail);
+		try_higher = false;
+	}
+
+	if (try_higher && detail > 0 && frame_cost(detail-1) <= MAX_FRAME_SAMPLES * 7/8) detail--;
+
+	particle_samples = MAX_FRAME_SAMPLES - min(cost, MAX_FRAME_SAMPLES);
+}
+
+
 // =====================================================================
 //						IObject - Interface for Objects
 // =====================================================================
 
 inline IObject::IObject(cstr _name) : name(_name), _next(this), _prev(this)
 {
-	printf("new %s\n",_name);
+	TRACE_VERBOSE(TRACE_NEW_OBJECT, trace_name(_name), uint32(uintptr_t(this)));
 }
 
 inline IObject::~IObject()
 {
-	printf("delete %s\n",name);
+	TRACE_VERBOSE(TRACE_DELETE_OBJECT, trace_name(name), uint32(uintptr_t(this)));
 	display_list.remove(this);
 }
 
@@ -305,13 +451,21 @@ Star::Star() : IObject(_star), position(rand(MINPOS,MAXPOS),rand(MINPOS,MAXPOS))
 	//printf("star at %.0f,%.0f\n",position.x,position.y);
 }
 
+static const LaserSet star_set{ .speed=1, .pattern=0x3ff, .delay_a=0, .delay_m=0, .delay_e=12 };
+
 void Star::draw() const
 {
-	static const LaserSet set{ .speed=1, .pattern=0x3ff, .delay_a=0, .delay_m=0, .delay_e=12 };
+	if (detail) return;		// stars are dropped first
 
 	XY2::resetTransformation();
 	XY2::setOffset(position.x,position.y);
-	XY2::drawLine(Point(),Point(),set);	// TODO: drawPoint()
+	XY2::drawLine(Point(),Point(),star_set);	// TODO: drawPoint()
+}
+
+uint Star::scan_cost (Point& pos, uint detail) const
+{
+	if (detail) return 0;
+	return XY2::costLine(pos,position,position,star_set,Transformation());
 }
 
 
@@ -321,12 +475,12 @@ void Star::draw() const
 
 static const char _score[] = "Score";
 
-Score::Score(const Point& position) : IObject(_score), position(position), score(0)
+Score::Score(const Point& position) : IObject(_score), position(position), score(0), text(Point(),400,400,"000",false,slow_straight,slow_rounded,vt_thin_font)
 {
 	::score = this;
 }
 
-Score::Score() : IObject(_score), position(MINPOS+5000,MAXPOS-11000), score(0)
+Score::Score() : IObject(_score), position(MINPOS+5000,MAXPOS-11000), score(0), text(Point(),400,400,"000",false,slow_straight,slow_rounded,vt_thin_font)
 {
 	::score = this;
 }
@@ -336,17 +490,34 @@ Score::~Score()
 	::score = nullptr;
 }
 
-void Score::draw() const
+static void format_score (char text[4], uint score)
 {
-	char text[] = "000";
-	uint score = this->score;
+	strcpy(text,"000");
 	if (score>=1000) { text[0] += score/1000; score %= 1000; }
 	if (score>=100)  { text[1] += score/100;  score %= 100; }
 	text[2] += score/10;
+}
+
+void Score::update_text() const
+{
+	char buffer[4];
+	format_score(buffer,score);
+	text.setText(buffer);		// recompiles only if changed
+}
+
+void Score::draw() const
+{
+	update_text();
 
 	XY2::resetTransformation();
 	XY2::setOffset(position.x,position.y);
-	XY2::printText(Point(),400,400,text);
+	text.draw();
+}
+
+uint Score::scan_cost (Point& pos, uint) const
+{
+	update_text();
+	return text.scan_cost(pos,Transformation(1,1,0,0,position.x,position.y));
 }
 
 
@@ -371,27 +542,41 @@ Lifes::~Lifes()
 	::lifes = nullptr;
 }
 
+static constexpr FLOAT lifes_size = 500;
+static const Point lifes_shape[] =
+{
+	{ 0*lifes_size, 0*lifes_size},
+	{-2*lifes_size, 1*lifes_size},
+	{ 0*lifes_size, 5*lifes_size},
+	{ 2*lifes_size, 1*lifes_size},
+};
+
 void Lifes::draw() const
 {
 	if (!lifes) return;			// no additional lifes left
 
-	static const FLOAT size = 500;
-	static Point shape[] =
-	{
-		{ 0*size, 0*size},
-		{-2*size, 1*size},
-		{ 0*size, 5*size},
-		{ 2*size, 1*size},
-	};
-
 	XY2::resetTransformation();
 	XY2::setOffset(position.x,position.y);
 
 	for (uint i=0; i<lifes; i++)
 	{
-		if (i) XY2::addOffset(size*6,0);
-		XY2::drawPolygon(4,shape,slow_straight);
+		if (i) XY2::addOffset(lifes_size*6,0);
+		XY2::drawPolygon(4,lifes_shape,slow_straight);
+	}
+}
+
+uint Lifes::scan_cost (Point& pos, uint) const
+{
+	uint cost = 0;
+	Transformation t;
+	t.setOffset(position.x,position.y);
+
+	for (uint i=0; i<lifes; i++)
+	{
+		if (i) t.addOffset(lifes_size*6,0);
+		cost += XY2::costPolygon(pos,4,lifes_shape,slow_straight,t);
 	}
+	return cost;
 }
 
 
@@ -441,19 +626,204 @@ void Object::move (FLOAT elapsed_time)
 }
 
 
+// =====================================================================
+//						ENTITY STORAGE
+// =====================================================================
+
+template<typename OBJ, uint N>
+void EntityStore<OBJ,N>::move (FLOAT elapsed_time)
+{
+	for (uint i=0; i<count; i++)
+	{
+		x[i] += dx[i] * elapsed_time;
+		y[i] += dy[i] * elapsed_time;
+	}
+
+	for (uint i=0; i<count; i++)
+	{
+		if (x[i] >= MINPOS && x[i] <= MAXPOS && y[i] >= MINPOS && y[i] <= MAXPOS) continue;
+
+		if (x[i] < MINPOS) x[i] += SIZE;
+		if (x[i] > MAXPOS) x[i] -= SIZE;
+		if (y[i] < MINPOS) y[i] += SIZE;
+		if (y[i] > MAXPOS) y[i] -= SIZE;
+
+		// ATTN: new insertion point may be before or after the Iterator!
+		display_list.remove(object[i]);
+		display_list.add(object[i]);
+	}
+}
+
+uint Asteroids::add (Asteroid* o, const Point& p, const Dist& m, FLOAT rotation, FLOAT radius)
+{
+	uint i = EntityStore::add(o,p,m);
+	this->angle[i] = 0;
+	this->rotation[i] = rotation;
+	this->radius[i] = radius;
+	this->sorted[i] = uint8(i);		// sorted into place by the next collide()
+	return i;
+}
+
+void Asteroids::remove (uint i)
+{
+	assert(i < count);
+
+	// remove i from sorted[] and rename the last index to i:
+	uint last = count - 1;
+	uint n = 0;
+	for (uint k=0; k<count; k++)
+	{
+		uint a = sorted[k];
+		if (a != i) sorted[n++] = uint8(a == last ? i : a);
+	}
+
+	if (i != --count)
+	{
+		copy(i,count);
+		angle[i] = angle[count];
+		rotation[i] = rotation[count];
+		radius[i] = radius[count];
+	}
+}
+
+void Asteroids::move (FLOAT elapsed_time)
+{
+	for (uint i=0; i<count; i++)
+	{
+		angle[i] += rotation[i] * elapsed_time;
+	}
+
+	EntityStore::move(elapsed_time);
+}
+
+void Asteroids::sort ()
+{
+	// insertion sort of sorted[] by left border
+	// the asteroids move only a little per step => sorted[] is almost sorted => O(n)
+
+	for (uint k=1; k<count; k++)
+	{
+		uint8 a = sorted[k];
+		FLOAT left = x[a] - radius[a];
+		uint j = k;
+		while (j && x[sorted[j-1]] - radius[sorted[j-1]] > left)
+		{
+			sorted[j] = sorted[j-1];
+			j--;
+		}
+		sorted[j] = a;
+	}
+}
+
+void Asteroids::collide ()
+{
+	// sweep and prune:
+	// walk the asteroids from left to right and test each one only against the following ones
+	// which start before its right border. then reject by the y range and by the radius.
+	// the polygons are tested only for the remaining few candidates.
+
+	sort();
+
+	for (uint k=0; k<count; k++)
+	{
+		uint a = sorted[k];
+		FLOAT right = x[a] + radius[a];
+
+		for (uint j=k+1; j<count; j++)
+		{
+			uint b = sorted[j];
+			if (x[b] - radius[b] > right) break;
+
+			FLOAT r = radius[a] + radius[b];
+			FLOAT ry = y[b] - y[a];
+			if (abs(ry) >= r) continue;
+			FLOAT rx = x[b] - x[a];
+			if (rx*rx + ry*ry >= r*r) continue;
+
+			bounce(a,b);
+		}
+	}
+}
+
+void Asteroids::bounce (uint a, uint b)
+{
+	// elastic collision of asteroids a and b
+	// the caller has done the radius test.
+
+	Point pa{x[a],y[a]};
+	Point pb{x[b],y[b]};
+	Dist  n = pb - pa;			// normal of the collision
+	FLOAT d = n.length();
+	if (d == 0) return;
+	n /= d;
+
+	// approaching? else they are already separating, e.g. fragments of a split asteroid:
+	FLOAT v = (dx[a]-dx[b]) * n.dx + (dy[a]-dy[b]) * n.dy;
+	if (v <= 0) return;
+
+	// polygon test: does a vertex of one asteroid lie inside the other?
+	Asteroid* oa = object[a];
+	Asteroid* ob = object[b];
+	const Point* va = oa->getWorldVertices();
+	const Point* vb = ob->getWorldVertices();
+	bool touching = false;
+	for (uint i=0; i<oa->num_vertices && !touching; i++) { touching = is_inside(ob->num_vertices,vb,va[i]); }
+	for (uint i=0; i<ob->num_vertices && !touching; i++) { touching = is_inside(oa->num_vertices,va,vb[i]); }
+	if (!touching) return;
+
+	// exchange momentum along the normal. mass ~ area ~ radius²:
+	FLOAT ma = radius[a] * radius[a];
+	FLOAT mb = radius[b] * radius[b];
+	FLOAT f = 2 * v / (ma + mb);
+	dx[a] -= f * mb * n.dx;
+	dy[a] -= f * mb * n.dy;
+	dx[b] += f * ma * n.dx;
+	dy[b] += f * ma * n.dy;
+}
+
+uint Bullets::add (Bullet* o, const Point& p, const Dist& m, FLOAT lifetime)
+{
+	uint i = EntityStore::add(o,p,m);
+	remaining_lifetime[i] = lifetime;
+	return i;
+}
+
+void Bullets::remove (uint i)
+{
+	assert(i < count);
+	if (i != --count)
+	{
+		copy(i,count);
+		remaining_lifetime[i] = remaining_lifetime[count];
+	}
+}
+
+void Bullets::move (FLOAT elapsed_time)
+{
+	// remove expired bullets:
+	// deleting a bullet moves the last one into the gap => iterate down
+	for (uint i=count; i--; )
+	{
+		remaining_lifetime[i] -= elapsed_time;
+		if (remaining_lifetime[i] <= 0) delete object[i];
+	}
+
+	EntityStore::move(elapsed_time);
+}
+
+
 // =====================================================================
 //							BULLET
 // =====================================================================
 
-const char _bullet[] = "Bullet";
+static const char _bullet[] = "Bullet";
 static uint max_bullets = 0;
-static char* spare_bullets[46] = {nullptr};
+static char* spare_bullets[Bullets::capacity] = {nullptr};
 static uint spare_bullets_count = 0;
 
 void* Bullet::operator new(std::size_t size)
 {
-	num_bullets++;
-	max_bullets = max(max_bullets, num_bullets);
+	max_bullets = max(max_bullets, bullets.count+1);
 
 	if (spare_bullets_count)
 		return spare_bullets[--spare_bullets_count];
@@ -463,7 +833,6 @@ void* Bullet::operator new(std::size_t size)
 
 void Bullet::operator delete (void* p)
 {
-	num_bullets--;
 	if (spare_bullets_count < NELEM(spare_bullets))
 		spare_bullets[spare_bullets_count++] = ptr(p);
 	else
@@ -471,32 +840,178 @@ void Bullet::operator delete (void* p)
 }
 
 Bullet::Bullet (const Point& p, const Dist& m) :
-	Object(_bullet, Transformation(m.dy/*fx*/,m.dy/*fy*/,m.dx/*sx*/,-m.dx/*sy*/,p.x,p.y), m),
-	remaining_lifetime(BULLET_LIFETIME)
+	IObject(_bullet),
+	idx(bullets.add(this,p,m,BULLET_LIFETIME))
 {}
 
+Bullet::~Bullet()
+{
+	bullets.remove(idx);
+}
+
+Point Bullet::origin() const
+{
+	return bullets.position(idx);
+}
+
 void Bullet::draw() const
 {
-	XY2::setTransformation(t);
+	// orientation follows the movement:
+	const FLOAT dx = bullets.dx[idx], dy = bullets.dy[idx];
+	const FLOAT x = bullets.x[idx] - dx * draw_lag;
+	const FLOAT y = bullets.y[idx] - dy * draw_lag;
+	XY2::setTransformation(dy/*fx*/,dy/*fy*/,dx/*sx*/,-dx/*sy*/,x,y);
 	XY2::drawLine(Point(0,0),Point(0,BULLET_LENGTH/10),fast_straight);
 }
 
-void Bullet::move (FLOAT elapsed_time)
+uint Bullet::scan_cost (Point& pos, uint) const
 {
-	remaining_lifetime -= elapsed_time;
-	if (remaining_lifetime <= 0) { delete this; return; }
+	const FLOAT dx = bullets.dx[idx], dy = bullets.dy[idx];
+	Transformation t(dy,dy,dx,-dx,bullets.x[idx],bullets.y[idx]);
+	return XY2::costLine(pos,Point(0,0),Point(0,BULLET_LENGTH/10),fast_straight,t);
+}
 
-	Object::move(elapsed_time);
 
-	// hit tests:
-	Point p0 = last_point();		// position of tip
-	for (IObject* o = _next; o!=this; o=o->_next)
+// =====================================================================
+//							PARTICLES
+// =====================================================================
+
+static const char _particles[] = "Particles";
+static constexpr FLOAT PARTICLE_STRIPE = SIZE/8;	// width of stripes for drawing order
+
+Particles::Particles() : IObject(_particles)
+{
+	particles = this;
+}
+
+Particles::~Particles()
+{
+	particles = nullptr;
+}
+
+Point Particles::origin() const
+{
+	if (count == 0) return Point();
+	uint i = order[0];
+	return Point(x[i],y[i]);
+}
+
+void Particles::add (const Point& p, const Dist& m, const Dist& h, FLOAT lifetime)
+{
+	if (count == capacity) return;		// effects are dropped first
+
+	uint i = count++;
+	x[i] = p.x; y[i] = p.y;
+	dx[i] = m.dx; dy[i] = m.dy;
+	hx[i] = h.dx; hy[i] = h.dy;
+	remaining_lifetime[i] = lifetime;
+	order[i] = uint8(i);				// sorted into place by the next move()
+}
+
+void Particles::explode (const Point& p, const Dist& m, uint count, FLOAT size, FLOAT speed)
+{
+	// add count fragments flying away from p in all directions
+
+	while (count--)
+	{
+		Dist  d, h;
+		fast_sincos(rand(2*pi), d.dx, d.dy);
+		fast_sincos(rand(2*pi), h.dx, h.dy);
+		d *= speed * rand(FLOAT(0.3),FLOAT(1.0));
+		h *= size * rand(FLOAT(0.3),FLOAT(1.0));
+		add(p, m + d, h, rand(FLOAT(0.4),FLOAT(1.0)));
+	}
+}
+
+void Particles::move (FLOAT elapsed_time)
+{
+	for (uint i=0; i<count; i++)
 	{
-		if (o->hit(p0))
+		x[i] += dx[i] * elapsed_time;
+		y[i] += dy[i] * elapsed_time;
+		remaining_lifetime[i] -= elapsed_time;
+	}
+
+	// remove expired particles and particles which left the screen:
+	// compact the arrays in one pass and remap order[]
+	uint8 new_index[capacity];
+	uint n = 0;
+	for (uint i=0; i<count; i++)
+	{
+		if (remaining_lifetime[i] <= 0 || x[i] < MINPOS || x[i] > MAXPOS || y[i] < MINPOS || y[i] > MAXPOS)
 		{
-			delete this;
-			return;
+			new_index[i] = 0xff;
+			continue;
+		}
+		new_index[i] = uint8(n);
+		if (n != i)
+		{
+			x[n] = x[i]; y[n] = y[i];
+			dx[n] = dx[i]; dy[n] = dy[i];
+			hx[n] = hx[i]; hy[n] = hy[i];
+			remaining_lifetime[n] = remaining_lifetime[i];
 		}
+		n++;
+	}
+
+	if (n != count)
+	{
+		uint k = 0;
+		for (uint j=0; j<count; j++)
+		{
+			uint8 i = new_index[order[j]];
+			if (i != 0xff) order[k++] = i;
+		}
+		count = n;
+	}
+
+	sort();
+}
+
+void Particles::sort()
+{
+	// insertion sort of order[] by stripe and in odd stripes by descending y
+	// the particles move only a little per step => order[] is almost sorted => O(n)
+
+	FLOAT key[capacity];
+	for (uint i=0; i<count; i++)
+	{
+		int stripe = int((x[i] - MINPOS) / PARTICLE_STRIPE);
+		key[i] = FLOAT(stripe) * 2*SIZE + (stripe & 1 ? -y[i] : y[i]);
+	}
+
+	for (uint k=1; k<count; k++)
+	{
+		uint8 a = order[k];
+		uint j = k;
+		while (j && key[order[j-1]] > key[a])
+		{
+			order[j] = order[j-1];
+			j--;
+		}
+		order[j] = a;
+	}
+}
+
+void Particles::draw() const
+{
+	// draw as many particles as fit into the remaining samples of this frame
+
+	XY2::resetTransformation();
+
+	uint samples = particle_samples;
+	Point pos = origin();
+
+	for (uint k=0; k<count; k++)
+	{
+		uint i = order[k];
+		Point p{x[i] - dx[i] * draw_lag, y[i] - dy[i] * draw_lag};
+		Dist  h{hx[i],hy[i]};
+
+		uint cost = XY2::costLine(pos, p-h, p+h, fast_straight);
+		if (cost > samples) break;
+		samples -= cost;
+		XY2::drawLine(p-h, p+h, fast_straight);
 	}
 }
 
@@ -505,21 +1020,18 @@ void Bullet::move (FLOAT elapsed_time)
 //							ASTEROID
 // =====================================================================
 
-const char _asteroid[] = "Asteroid";
+static const char _asteroid[] = "Asteroid";
 
 Asteroid::~Asteroid()
 {
-	num_asteroids--;
+	asteroids.remove(idx);
 }
 
 Asteroid::Asteroid (uint size, const Point& p, const Dist& m, FLOAT rotation) :
-	Object(_asteroid, Transformation(1,1,0,0, p.x,p.y), m),
-	size(size),
-	rotation(rotation)
+	IObject(_asteroid),
+	size(size)
 {
-	num_asteroids++;
-
-	FLOAT jitter;
+	FLOAT radians, jitter;
 	switch(size)
 	{
 	case 1: num_vertices =  4; radians = SIZE/1000*15; jitter = radians/2; break;
@@ -528,72 +1040,134 @@ Asteroid::Asteroid (uint size, const Point& p, const Dist& m, FLOAT rotation) :
 	default:num_vertices = 16; radians = SIZE/1000*40; jitter = radians/5; break;
 	}
 
-	for (uint i=0; i<num_vertices; i++)
+	idx = asteroids.add(this,p,m,rotation,radians);
+
+	SinCosStepper a(0, 2*pi / num_vertices);
+	for (uint i=0; i<num_vertices; i++, a.next())
 	{
-		FLOAT a = 2*pi * i / num_vertices;
-		FLOAT x = sin(a) * radians + rand(-jitter,+jitter);
-		FLOAT y = cos(a) * radians + rand(-jitter,+jitter);
+		FLOAT x = a.sin * radians + rand(-jitter,+jitter);
+		FLOAT y = a.cos * radians + rand(-jitter,+jitter);
 		new(vertices+i) Point(x,y);
 	}
 }
 
+Point Asteroid::origin() const
+{
+	return asteroids.position(idx);
+}
+
+Transformation Asteroid::getTransformation() const
+{
+	Transformation t;
+	t.setRotation(asteroids.angle[idx]);
+	t.setOffset(asteroids.x[idx],asteroids.y[idx]);
+	return t;
+}
+
+const Point* Asteroid::getWorldVertices()
+{
+	// get the vertices in world space
+	// they are transformed at most once per simulation step and only if they are needed
+
+	if (world_step != sim_step)
+	{
+		world_step = sim_step;
+		getTransformation().transform(num_vertices, vertices, world_vertices);
+	}
+	return world_vertices;
+}
+
 void Asteroid::draw() const
 {
+	Transformation t;
+	t.setRotation(asteroids.angle[idx] - asteroids.rotation[idx] * draw_lag);
+	t.setOffset(asteroids.position(idx) - asteroids.movement(idx) * draw_lag);
 	XY2::setTransformation(t);
-	XY2::drawPolygon(num_vertices,vertices,fast_rounded);
+
+	// reduced detail: draw only every 2nd or 4th vertex, but at least 4:
+	uint stride = min(1u << detail, num_vertices / 4);
+	if (stride == 1) return XY2::drawPolygon(num_vertices,vertices,fast_rounded);
+
+	const Point* p = vertices;
+	XY2::drawPolygon(num_vertices/stride, [&p,stride](){ Point q = *p; p += stride; return q; }, fast_rounded);
 }
 
-void Asteroid::move(FLOAT elapsed_time)
+uint Asteroid::scan_cost (Point& pos, uint detail) const
 {
-	rotate(rotation*elapsed_time);
-	Object::move(elapsed_time);
-
-	// collission test with Alien
-	// TODO
+	uint stride = min(1u << detail, num_vertices / 4);
+	const Point* p = vertices;
+	return XY2::costPolygon(pos, num_vertices/stride, [&p,stride](){ Point q = *p; p += stride; return q; },
+							fast_rounded, getTransformation());
+}
 
-	// collission test with other Asteroid
-	// TODO
+void Asteroid::collide_with_player()
+{
+	// test for overlap with all of our vertices:
+	// the caller has already done the radius test.
 
-	// collission test with player:
+	const Point* p = getWorldVertices();
 
-	if ((origin()-player->origin()).length() < radians+SHIELD_RADIANS*SIZE/90)
+	for (uint i=0; i<num_vertices; i++)
 	{
-		// test for overlap with all of our vertices:
-		for (uint i=0; i<num_vertices; i++)
+		if (player->hit(p[i]))
 		{
-			Point p = vertices[i];
-			t.transform(p);
-			if (player->hit(p))
-			{
-				hit(origin());	// hit self
-				return;			// and we are gone
-			}
+			split(origin());
+			return;			// and we are gone
 		}
 	}
 }
 
 bool Asteroid::hit (const Point& p)
 {
+	const Point  position = origin();
+	const FLOAT  radians  = asteroids.radius[idx];
+
 	// quick test:
-	if (dist(p,origin()) > radians) return false;
+	if (dist(p,position) > radians) return false;
 
 	// better test:
-	if ((p-origin()).length() > radians) return false;
+	if ((p-position).length() > radians) return false;
 
 	// polygon test:
-	// TODO
+	if (!is_inside(num_vertices,getWorldVertices(),p)) return false;
+
+	split(p);
+	return true;
+}
+
+bool Asteroid::hit (const Point& a, const Point& b)
+{
+	// test the path from a to b
+	// the caller has already done the bounding box test.
+
+	if (!segment_hits_circle(a,b,origin(),asteroids.radius[idx])) return false;
+
+	Point p;
+	if (!segment_hits_polygon(num_vertices,getWorldVertices(),a,b,p)) return false;
+
+	split(p);
+	return true;
+}
+
+void Asteroid::split (const Point& p)
+{
+	// split into 3 smaller ones at hit point p
+	// and delete this
 
 	score->score+=10;
+	particles->explode(p, asteroids.movement(idx), 2+3*size, asteroids.radius[idx]/8, SIZE/8);
 
 	if (size == 1)
 	{
 		delete this;
-		return true;
+		return;
 	}
 
-	// split into 3 smaller ones
+	const FLOAT radians  = asteroids.radius[idx];
+	const Dist  movement = asteroids.movement(idx);
+	const FLOAT rotation = asteroids.rotation[idx];
 	Dist dist0{0.0f, radians * 0.666f};		// offset to new asteroid's center
-	for (int i=0; i<=2; i++)
+	for (int i=0; i<=2 && !asteroids.isFull(); i++)
 	{
 		dist0.rotate(i ? pi*2/3 : rand(pi/3));
 		FLOAT rot0 = rotation * rand(0.666f,1.5f);
@@ -603,7 +1177,6 @@ bool Asteroid::hit (const Point& p)
 	}
 
 	delete this;
-	return true;
 }
 
 
@@ -613,19 +1186,11 @@ bool Asteroid::hit (const Point& p)
 
 const char _player[] = "Player";
 
-static bool is_right_of (const Point& p1, const Point& p2, const Point& pt)
-{
-	// test whether pt is right of line from p1 to p2
-
-	Dist a{p2-p1};
-	Dist b{pt-p1};
-	return a.dx*b.dy < a.dy*b.dx;
-}
-
 // always at (0,0) with 0 speed and no rotation:
 Player::Player() : Object(_player, Transformation(SIZE/90,SIZE/90, 0,0, 0,0), Dist(0,0))
 {
 	player = this;
+	update_hull();
 }
 
 Player::~Player()
@@ -644,34 +1209,55 @@ static const Point player_ship_shape[] =
 	{0,2.5f}
 };
 
+// thrust:
+static const Point thrust_shape[][3] =
+{
+	{{-0.75f,-2.5f}, {0,-1-2.5f},{+0.75f,-2.5f}},	// acc=1
+	{{-1,    -2.5f}, {0,-2-2.5f},{+1,    -2.5f}},	// acc=2
+	{{-1.25f,-2.5f}, {0,-3-2.5f},{+1.25f,-2.5f}}	// acc=3
+};
+
 void Player::draw() const
 {
+	Transformation t{this->t};
+	t.rotate(-rotation * draw_lag);
+	t.addOffset(movement * -draw_lag);
 	XY2::setTransformation(t);
 
 	if (shield)
 	{
 		const FLOAT r = SHIELD_RADIANS;
-		Rect bbox{r,-r,-r,r};
-		XY2::drawEllipse(bbox,-pi/2,8,fast_rounded);
+		XY2::drawArc(Point(0,0),r,r,-pi/2,2*pi,fast_rounded);
 	}
 
-	// thrust:
-	static Point acc[][3] =
-	{
-		{{-0.75f,-2.5f}, {0,-1-2.5f},{+0.75f,-2.5f}},	// acc=1
-		{{-1,    -2.5f}, {0,-2-2.5f},{+1,    -2.5f}},	// acc=2
-		{{-1.25f,-2.5f}, {0,-3-2.5f},{+1.25f,-2.5f}}	// acc=3
-	};
-
+	// thrust is dropped in reduced detail:
 	static bool flicker=0;
-	if (accelerating && (flicker=!flicker))
+	if (accelerating && !detail && (flicker=!flicker))
 	{
-		XY2::drawPolyLine(3,acc[minmax(0,accelerating/8,2)],fast_straight);
+		XY2::drawPolyLine(3,thrust_shape[minmax(0,accelerating/8,2)],fast_straight);
 	}
 
 	XY2::drawPolyLine(6,player_ship_shape,slow_straight);
 }
 
+uint Player::scan_cost (Point& pos, uint detail) const
+{
+	uint cost = 0;
+
+	if (shield)
+	{
+		const FLOAT r = SHIELD_RADIANS;
+		cost += XY2::costArc(pos,Point(0,0),r,r,-pi/2,2*pi,fast_rounded,t);
+	}
+
+	if (accelerating && !detail)	// drawn every 2nd frame
+	{
+		cost += XY2::costPolyLine(pos,3,thrust_shape[minmax(0,accelerating/8,2)],fast_straight,POLYLINE_DEFAULT,t) / 2;
+	}
+
+	return cost + XY2::costPolyLine(pos,6,player_ship_shape,slow_straight,POLYLINE_DEFAULT,t);
+}
+
 void Player::accelerate()
 {
 	if (!accelerating) return;
@@ -683,19 +1269,36 @@ void Player::accelerate()
 	d *= FLOAT(a) / 4;
 	movement += d;
 
+	// exhaust:
+	if (sim_step % 4 == 0)
+	{
+		Dist e = getDirection();
+		e /= e.length();
+		Point tail = t.transformed(Point(0,-3));
+		particles->add(tail, movement - e * (SIZE/4), e * (SIZE/400), FLOAT(0.25));
+	}
+
 	if (movement.length() > SIZE/5)	// max speed limiter
 	{
 		movement *= FLOAT(0.98);
 	}
 }
 
+void Player::update_hull()
+{
+	// transfer player ship to global space
+	// hit() is called for many points per step
+
+	static const Point shape[4] = { {0,-2},{-2,-1},{0,3},{2,-1} };	// == player_ship_shape
+	t.transform(4, shape, hull);
+}
+
 void Player::move(FLOAT elapsed_time)
 {
 	accelerate();
 	rotate(rotation*elapsed_time);
 	Object::move(elapsed_time);
-
-	// TODO: collission / hit test
+	update_hull();
 }
 
 bool Player::hit (const Point& pt)
@@ -711,20 +1314,14 @@ bool Player::hit (const Point& pt)
 
 	if (shield) return true;	// TODO: animation?
 
-	Point shape[4] = { {0,-2},{-2,-1},{0,3},{2,-1} };	// == player_ship_shape
-	for (uint i=0;i<4;i++)
+	if (is_right_of(hull[0],hull[1],pt) &&
+		is_right_of(hull[1],hull[2],pt) &&
+		is_right_of(hull[2],hull[3],pt) &&
+		is_right_of(hull[3],hull[0],pt))
 	{
-		t.transform(shape[i]);	// transfer player ship to global space
-	}
-
-	if (is_right_of(shape[0],shape[1],pt) &&
-		is_right_of(shape[1],shape[2],pt) &&
-		is_right_of(shape[2],shape[3],pt) &&
-		is_right_of(shape[3],shape[0],pt))
-	{
-		// TODO Animation
 		is_dead = true;
 		accelerating = false;
+		particles->explode(getPosition(), movement, 24, SIZE/150, SIZE/6);
 		return true;
 	}
 
@@ -775,6 +1372,7 @@ void Player::activateShield (bool f)
 void Player::shootCannon()
 {
 	if (is_dead) return;
+	if (bullets.isFull()) return;
 
 	shield = false;
 	Dist movement{getDirection().normalized()*BULLET_SPEED};
@@ -822,8 +1420,20 @@ Alien::~Alien()
 //							THE GAME
 // =====================================================================
 
+void Laseroids::move_and_draw_particles (FLOAT elapsed_time)
+{
+	// let the debris of the player ship fly while the game is paused
+
+	particles->move(elapsed_time);
+	draw_lag = 0;
+	particle_samples = MAX_FRAME_SAMPLES / 2;
+	particles->draw();
+}
+
 void Laseroids::draw_all()
 {
+	select_detail();
+
 	for (IObject* o = display_list.first(); o; o = display_list.next())
 	{
 		o->draw();
@@ -835,20 +1445,92 @@ void Laseroids::move_all (FLOAT elapsed_time)
 	// move all objects
 	// this includes collission detection and objects may be added or removed at random.
 
-	for (IObject* o = display_list.first(); o; o = display_list.next())
+	// stars, score and lifes don't move.
+	// asteroids and bullets are moved in batch:
+
+	sim_step++;
+	bullets.move(elapsed_time);
+	asteroids.move(elapsed_time);
+	asteroids.collide();
+	player->move(elapsed_time);
+	if (alien) alien->move(elapsed_time);
+	particles->move(elapsed_time);
+
+	hit_test_bullets(elapsed_time);
+	hit_test_player();
+}
+
+static bool hit_asteroid (const Point& p0, const Point& p1)
+{
+	// test the path p0 -> p1 of a bullet against all asteroids
+
+	// bounding box of the path:
+	const FLOAT x0 = min(p0.x,p1.x), x1 = max(p0.x,p1.x);
+	const FLOAT y0 = min(p0.y,p1.y), y1 = max(p0.y,p1.y);
+
+	for (uint a = 0; a < asteroids.count; a++)
 	{
-		o->move(elapsed_time);
+		// reject fast with the bounding boxes:
+		const FLOAT r = asteroids.radius[a];
+		if (asteroids.x[a] + r < x0 || asteroids.x[a] - r > x1) continue;
+		if (asteroids.y[a] + r < y0 || asteroids.y[a] - r > y1) continue;
+		if (asteroids.object[a]->hit(p0,p1)) return true;
 	}
+	return false;
 }
 
-void Laseroids::remove_bullets()
+void Laseroids::hit_test_bullets (FLOAT elapsed_time)
 {
-	for (IObject* o = display_list.first(); o; o = display_list.next())
+	// test the path of all bullets in the last step against all asteroids and the alien.
+	// the path is tested, not only the tip, because bullets move more than the size of small asteroids per step.
+	// the player is not tested: his own bullets start inside the ship's hull.
+	// a hit asteroid is removed and up to 3 fragments are appended to asteroids[]
+	// a hit bullet is removed and the last bullet is moved into the gap => iterate down
+
+	for (uint b = bullets.count; b--; )
+	{
+		const Point p1{bullets.x[b],bullets.y[b]};						// position of tip
+		const Point p0 = p1 - bullets.movement(b) * elapsed_time;		// before the step
+
+		// if the bullet wrapped at a border in this step then p0 is outside the field:
+		// the path before the wrap is tested in the other image of the field.
+		const Dist d { p0.x < MINPOS ? SIZE : p0.x > MAXPOS ? -SIZE : 0,
+					   p0.y < MINPOS ? SIZE : p0.y > MAXPOS ? -SIZE : 0 };
+
+		bool hit = hit_asteroid(p0,p1);
+		if (!hit && (d.dx != 0 || d.dy != 0)) hit = hit_asteroid(p0+d,p1+d);
+
+		if (hit || (alien && alien->hit(p1)))
+		{
+			delete bullets.object[b];
+		}
+	}
+}
+
+void Laseroids::hit_test_player()
+{
+	// a hit asteroid is removed and the last asteroid is moved into the gap => iterate down
+
+	const FLOAT x = player->t.dx;
+	const FLOAT y = player->t.dy;
+	const FLOAT player_radius = SHIELD_RADIANS*SIZE/90;
+
+	for (uint a = asteroids.count; a--; )
 	{
-		if (o->name == _bullet) delete o;
+		const FLOAT dx = asteroids.x[a] - x;
+		const FLOAT dy = asteroids.y[a] - y;
+		const FLOAT r  = asteroids.radius[a] + player_radius;
+		if (dx*dx + dy*dy >= r*r) continue;
+
+		asteroids.object[a]->collide_with_player();
 	}
 }
 
+void Laseroids::remove_bullets()
+{
+	while (bullets.count) { delete bullets.object[bullets.count-1]; }
+}
+
 void Laseroids::draw_big_message (cstr text)
 {
 	XY2::resetTransformation();
@@ -862,7 +1544,7 @@ void Laseroids::start_new_level (uint level)
 	delete alien;
 	remove_bullets();
 
-	while (num_asteroids < level)
+	while (asteroids.count < level && !asteroids.isFull())
 	{
 		Point pt{rand(MINPOS,MAXPOS),rand(MINPOS,MAXPOS)};
 		if ((pt-Point()).length() < SIZE/10) continue;	// too close to player
@@ -876,12 +1558,33 @@ void Laseroids::start_new_level (uint level)
 	display_list.add(new Player);
 }
 
-void Laseroids::runOneFrame()
+void Laseroids::handleInput (Input input)
 {
-	uint32 now = time_us_32();
-	FLOAT elapsed_time = min(now - time_last_run_us, uint32(100000)) * FLOAT(1e-6);
+	if (state != IDLE) recorder.input(input);
+	if (!player) return;
+
+	switch (input)
+	{
+	case ACCELERATE_SHIP: player->accelerateShip(); return;
+	case ROTATE_RIGHT:	  player->rotateRight(); return;
+	case ROTATE_LEFT:	  player->rotateLeft(); return;
+	case SHIELD_ON:		  player->activateShield(true); return;
+	case SHIELD_OFF:	  player->activateShield(false); return;
+	case SHOOT_CANNON:	  player->shootCannon(); return;
+	}
+}
+
+void Laseroids::runOneFrame (uint32 now)
+{
+	uint32 elapsed_us = now - time_last_run_us;
+	FLOAT elapsed_time = min(elapsed_us, uint32(100000)) * FLOAT(1e-6);
 	time_last_run_us = now;
 
+	// record time for replay:
+	// the random seed is derived from the time of the first frame
+	if (state == START_NEW_GAME) recorder.start(now);
+	else if (state != IDLE) recorder.frame(elapsed_us);
+
 	switch (state)
 	{
 	case IDLE:
@@ -891,7 +1594,8 @@ void Laseroids::runOneFrame()
 	case START_NEW_GAME:
 	{
 		time_start_of_game_us = now;
-		srand(now);
+		time_accumulated = 0;
+		srand32(now);
 
 		display_list.~DisplayList();
 		new(&display_list) DisplayList;
@@ -899,11 +1603,13 @@ void Laseroids::runOneFrame()
 		assert(alien == nullptr);
 		assert(lifes == nullptr);
 		assert(score == nullptr);
-		assert(num_asteroids == 0);
-		assert(num_bullets == 0);
+		assert(particles == nullptr);
+		assert(asteroids.count == 0);
+		assert(bullets.count == 0);
 
 		display_list.add(new Lifes);
 		display_list.add(new Score);
+		display_list.add(new Particles);
 		for (uint i=0; i<NUM_STARS; i++) { display_list.add(new Star); }
 
 		start_new_level(1);
@@ -916,7 +1622,7 @@ void Laseroids::runOneFrame()
 		draw_big_message("Get Ready!");
 
 		state_countdown -= elapsed_time;
-		if (state_countdown <= 0) state = GAME;
+		if (state_countdown <= 0) { state = GAME; time_accumulated = 0; }
 		return;
 	}
 	case LEVEL_COMPLETED:
@@ -936,6 +1642,7 @@ void Laseroids::runOneFrame()
 	{
 		if (uint(state_countdown*5)%2)
 			draw_big_message("respawning");
+		move_and_draw_particles(elapsed_time);
 
 		state_countdown -= elapsed_time;
 		if (state_countdown <= 0)
@@ -946,16 +1653,32 @@ void Laseroids::runOneFrame()
 			display_list.add(new Player);
 			player->shield = true;
 			state = GAME;
+			time_accumulated = 0;
 		}
 		return;
 	}
 	case GAME:
 	{
-		move_all(elapsed_time);
+		// run the simulation in fixed time steps:
+		// => gameplay does not depend on the frame rate and fast bullets can't tunnel.
+		TRACE(TRACE_SIMULATE_BEGIN);
+		uint steps = 0;
+		time_accumulated += elapsed_time;
+		while (time_accumulated >= TIME_STEP && asteroids.count && !player->is_dead)
+		{
+			move_all(TIME_STEP);
+			time_accumulated -= TIME_STEP;
+			steps++;
+		}
+		TRACE(TRACE_SIMULATE_END, steps);
+
+		TRACE(TRACE_DRAW_BEGIN);
 		display_list.optimize();
+		draw_lag = max(TIME_STEP - time_accumulated, FLOAT(0));
 		draw_all();
+		TRACE(TRACE_DRAW_END, detail);
 
-		if (num_asteroids==0)
+		if (asteroids.count==0)
 		{
 			state = LEVEL_COMPLETED;
 			state_countdown = FLOAT(2.0);
@@ -979,11 +1702,13 @@ void Laseroids::runOneFrame()
 	case GAME_OVER:
 	{
 		draw_big_message("GAME OVER");
+		move_and_draw_particles(elapsed_time);
 
 		state_countdown -= elapsed_time;
 		if (state_countdown <= 0)
 		{
 			printf("max_bullets = %u\n", max_bullets);
+			recorder.stop(getScore());
 			state = IDLE;
 		}
 		return;
@@ -1007,42 +1732,17 @@ FLOAT Laseroids::getPlaytime()
 	return (time_last_run_us - time_start_of_game_us) * FLOAT(1e-6);
 }
 
+uint Laseroids::getLevel()
+{
+	return level;
+}
 
+uint Laseroids::getNumAsteroids()
+{
+	return asteroids.count;
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+uint Laseroids::getNumBullets()
+{
+	return bullets.count;
+}
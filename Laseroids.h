@@ -7,6 +7,8 @@
 #pragma once
 #include "cdefs.h"
 #include "basic_geometry.h"
+#include "hardware/timer.h"
+#include "CompiledText.h"
 
 
 class IObject
@@ -24,6 +26,7 @@ public:
 	virtual void draw() const = 0;
 	virtual void move(FLOAT elapsed_time) = 0;
 	virtual bool hit (const Point&) { return false; }
+	virtual uint scan_cost (Point& /*pos*/, uint /*detail*/) const { return 0; }	// estimated samples for draw()
 
 	cstr name;
 	IObject* _next;
@@ -67,6 +70,7 @@ public:
 	Star();		// star at random position
 
 	virtual void draw() const override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
 	virtual void move(FLOAT elapsed_time) override {} // does not move
 	virtual Point origin() const override { return position; }
 
@@ -81,11 +85,16 @@ public:
 	virtual ~Score() override;
 
 	virtual void draw() const override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
 	virtual void move(FLOAT) override {} // does not move
 	virtual Point origin() const override { return position; }
 
 	Point position;
 	uint score = 0;
+
+private:
+	mutable CompiledText text;	// recompiled when the score changes
+	void update_text() const;
 };
 
 class Lifes : public IObject
@@ -95,6 +104,7 @@ public:
 	Lifes();	// display of lifes left at standard position
 	virtual ~Lifes() override;
 	virtual void draw() const override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
 	virtual void move(FLOAT) override {} // does not move
 	virtual Point origin() const override { return position; }
 
@@ -132,36 +142,118 @@ public:
 };
 
 
-class Bullet : public Object
+class Bullet : public IObject
 {
 public:
 	void* operator new(std::size_t size);
 	void operator delete(void*);
 
 	Bullet(const Point& position, const Dist& movement);
+	virtual ~Bullet() override;
 
 	virtual void draw() const override;
-	virtual void move(FLOAT elapsed_time) override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
+	virtual void move(FLOAT) override {} // moved by Bullets::move()
+	virtual Point origin() const override;
 
-	FLOAT remaining_lifetime;
+	uint idx;				// index in bullets[]
 };
 
 
-class Asteroid : public Object
+class Asteroid : public IObject
 {
 public:
 	virtual ~Asteroid() override;
 	Asteroid(uint size_id, const Point& position, const Dist& speed, FLOAT rotation=0);
 
 	virtual void draw() const override;
-	virtual void move(FLOAT elapsed_time) override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
+	virtual void move(FLOAT) override {} // moved by Asteroids::move()
+	virtual Point origin() const override;
 	virtual bool hit (const Point& p) override;
+	bool hit (const Point& a, const Point& b);	// swept test for the path from a to b
+
+	Transformation getTransformation() const;
+	const Point* getWorldVertices();
+	void collide_with_player();
+	void split (const Point& p);	// split into fragments or vanish
 
+	uint  idx;				// index in asteroids[]
 	uint  size;				// size class: 1 .. 4
 	Point vertices[16];
 	uint  num_vertices;
-	FLOAT radians;
-	FLOAT rotation = 0;		// rotational speed
+	Point world_vertices[16];	// cache for getWorldVertices()
+	uint  world_step = ~0u;		// simulation step of world_vertices[]
+};
+
+
+/*	Structure of Arrays for the moving objects:
+	The hot data of all asteroids and all bullets is kept in contiguous per-type arrays.
+	Moving and hit testing is done in tight loops over these arrays
+	without walking the display list or calling virtual functions.
+	The objects in the display list only keep the index of their data in the store.
+	Removing an entry moves the last entry into the gap.
+*/
+template<typename OBJ, uint N>
+struct EntityStore
+{
+	static constexpr uint capacity = N;
+
+	uint  count = 0;
+	FLOAT x[N], y[N];		// position
+	FLOAT dx[N], dy[N];		// movement per second
+	OBJ*  object[N];		// the owner of the data at this index
+
+	bool isFull() const { return count >= N; }
+	Point position (uint i) const { return Point(x[i],y[i]); }
+	Dist  movement (uint i) const { return Dist(dx[i],dy[i]); }
+
+	void move (FLOAT elapsed_time);	// add movement to position and wrap at borders
+
+protected:
+	uint add (OBJ* o, const Point& p, const Dist& m)
+	{
+		assert(count < N);
+		uint i = count++;
+		x[i] = p.x; y[i] = p.y;
+		dx[i] = m.dx; dy[i] = m.dy;
+		object[i] = o;
+		return i;
+	}
+
+	void copy (uint z, uint q)	// helper for remove()
+	{
+		x[z] = x[q]; y[z] = y[q];
+		dx[z] = dx[q]; dy[z] = dy[q];
+		object[z] = object[q];
+		object[z]->idx = z;
+	}
+};
+
+struct Asteroids : public EntityStore<Asteroid,240>
+{
+	FLOAT angle[capacity];		// orientation
+	FLOAT rotation[capacity];	// rotational speed
+	FLOAT radius[capacity];		// for hit tests
+	uint8 sorted[capacity];		// indexes sorted by left border x-radius, for collide()
+
+	uint add (Asteroid*, const Point&, const Dist&, FLOAT rotation, FLOAT radius);
+	void remove (uint i);
+	void move (FLOAT elapsed_time);
+	void collide ();			// let asteroids bounce off each other
+
+private:
+	void sort ();
+	void bounce (uint a, uint b);
+};
+
+struct Bullets : public EntityStore<Bullet,64>
+{
+	FLOAT remaining_lifetime[capacity];
+
+	uint add (Bullet*, const Point&, const Dist&, FLOAT lifetime);
+	void remove (uint i);
+	void move (FLOAT elapsed_time);
 };
 
 
@@ -172,9 +264,13 @@ public:
 	virtual ~Player() override;
 
 	virtual void draw() const override;
+	virtual uint scan_cost (Point& pos, uint detail) const override;
 	virtual void move(FLOAT elapsed_time) override;
 	virtual bool hit (const Point& p) override;
 
+	Point hull[4];			// ship hull in world space, for hit()
+	void update_hull();
+
 	bool shield = false;
 	bool is_dead = false;
 	uint accelerating = 0;
@@ -201,6 +297,40 @@ public:
 };
 
 
+/*	Particles:
+	Debris of exploding asteroids and of the player ship and the exhaust of the ship's engine.
+	All particles are kept in one fixed size structure of arrays and are drawn by this one object.
+	They are moved in batch and drawn as short lines in stripes from left to right, alternating up and down,
+	which keeps the jumps between them short.
+	Particles are not included in the level of detail: they are drawn as far as the remaining samples allow.
+*/
+class Particles : public IObject
+{
+public:
+	static constexpr uint capacity = 128;
+
+	Particles();
+	virtual ~Particles() override;
+
+	virtual void draw() const override;
+	virtual void move(FLOAT elapsed_time) override;
+	virtual Point origin() const override;
+
+	void add (const Point& position, const Dist& movement, const Dist& half_line, FLOAT lifetime);
+	void explode (const Point& position, const Dist& movement, uint count, FLOAT size, FLOAT speed);
+
+	uint  count = 0;
+	FLOAT x[capacity], y[capacity];		// center of line
+	FLOAT dx[capacity], dy[capacity];	// movement per second
+	FLOAT hx[capacity], hy[capacity];	// half of the line
+	FLOAT remaining_lifetime[capacity];
+	uint8 order[capacity];				// drawing order
+
+private:
+	void sort();
+};
+
+
 extern Player* player;
 
 
@@ -211,16 +341,32 @@ public:
 	~Laseroids()=default;
 
 	void startNewGame() { state=START_NEW_GAME; }
-	static void runOneFrame();
+	static void runOneFrame() { runOneFrame(time_us_32()); }
+	static void runOneFrame(uint32 now_us);		// for replay
+
+	// input events are recorded for replay:
+	enum Input : uint8
+	{
+		ACCELERATE_SHIP,
+		ROTATE_RIGHT,
+		ROTATE_LEFT,
+		SHIELD_ON,
+		SHIELD_OFF,
+		SHOOT_CANNON,
+	};
+	static void handleInput (Input);
 
-	static void accelerateShip() { if (player) player->accelerateShip(); }
-	static void rotateRight()	 { if (player) player->rotateRight(); }
-	static void rotateLeft()	 { if (player) player->rotateLeft(); }
-	static void activateShield(bool f=1) { if (player) player->activateShield(f); }
-	static void shootCannon()	 { if (player) player->shootCannon(); }
+	static void accelerateShip() { handleInput(ACCELERATE_SHIP); }
+	static void rotateRight()	 { handleInput(ROTATE_RIGHT); }
+	static void rotateLeft()	 { handleInput(ROTATE_LEFT); }
+	static void activateShield(bool f=1) { handleInput(f ? SHIELD_ON : SHIELD_OFF); }
+	static void shootCannon()	 { handleInput(SHOOT_CANNON); }
 	static bool isGameOver()	 { return state == IDLE; }
 	static uint getScore();
 	static FLOAT getPlaytime();
+	static uint getLevel();
+	static uint getNumAsteroids();
+	static uint getNumBullets();
 
 	enum State
 	{
@@ -237,9 +383,13 @@ public:
 private:
 	static void move_all (FLOAT elapsed_time);
 	static void draw_all ();
+	static void move_and_draw_particles (FLOAT elapsed_time);
+	static void select_detail ();
 	static void draw_big_message(cstr text);
 	static void start_new_level(uint num_asteroids);
 	static void remove_bullets();
+	static void hit_test_bullets(FLOAT elapsed_time);
+	static void hit_test_player();
 };
 
 
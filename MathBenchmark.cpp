@@ -0,0 +1,319 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "MathBenchmark.h"
+#include "cdefs.h"
+#include "utilities.h"
+#include "basic_geometry.h"
+#include "fast_trig.h"
+#include "Queue.h"
+#include "XY2.h"
+#include "Wireframe.h"
+#include <math.h>
+#include <string.h>
+#ifdef __arm__
+  #include "hardware/clocks.h"
+#else
+  #include <chrono>
+#endif
+
+
+static constexpr uint N = 256;				// inputs per run
+static constexpr uint64 min_time_ns = 20*1000*1000;
+
+static volatile FLOAT sink;					// results are written here so that they are not optimized away
+
+
+// ====================================================================
+//		timing and report
+// ====================================================================
+
+#ifdef __arm__
+static uint64 now_ns () { return time_us_64() * 1000; }
+#else
+static uint64 now_ns ()
+{
+	return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				  std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#endif
+
+template<typename F>
+static double measure (F kernel)
+{
+	// run kernel() until min_time_ns has passed
+	// kernel() performs N operations
+	// return time per operation in ns
+
+	uint64 t0 = now_ns();
+	uint64 dt = 0;
+	uint runs = 0;
+	for (uint n = 1; dt < min_time_ns; n *= 2)
+	{
+		for (uint i=0; i<n; i++) kernel();
+		runs += n;
+		dt = now_ns() - t0;
+	}
+	return double(dt) / runs / N;
+}
+
+static void print_header ()
+{
+	printf("%-32s %10s %10s  %s\n", "kernel", "ns/op", "cycles/op", "max. error");
+}
+
+static void report (cstr name, double ns, double error, cstr error_unit)
+{
+  #ifdef __arm__
+	double cycles = ns * clock_get_hz(clk_sys) / 1e9;
+	printf("%-32s %10.1f %10.0f", name, ns, cycles);
+  #else
+	printf("%-32s %10.1f %10s", name, ns, "-");
+  #endif
+	if (error_unit) printf("  %.3g %s\n", error, error_unit);
+	else printf("  -\n");
+}
+
+
+// ====================================================================
+//		kernels under test which are not in the tree
+// ====================================================================
+
+template<uint iter>
+static inline float q3_inverse_sqrt (float x)
+{
+	// the Quake III algorithm for 1/sqrt(x), see Q3_inverse_sqrt/
+
+	float x2 = x * 0.5f;
+	int32 i;
+	memcpy(&i, &x, 4);
+	i = 0x5f3759df - (i>>1);
+	float y;
+	memcpy(&y, &i, 4);
+
+	for (uint i=0; i<iter; i++) y *= 1.5f - x2*y*y;		// Newton's Iteration
+	return y;
+}
+
+static uint step_line (Point& pos0, Point dest, FLOAT speed)
+{
+	// the sample stepping of XY2::draw_to() with its LineStepper, without PIO and laser delay
+	// returns the number of samples
+
+	LineStepper line(pos0, dest, speed);
+
+	uint n = 0;
+	while (line.next())
+	{
+		pos0 += line.step;
+		sink = pos0.x;
+		n++;
+	}
+	if (pos0 != dest) { pos0 = dest; sink = pos0.x; n++; }
+	return n;
+}
+
+
+// ====================================================================
+//		benchmarks
+// ====================================================================
+
+static FLOAT a[N], b[N];		// inputs
+static FLOAT r[N];				// results
+static Point p[N], q[N];
+
+static void bench_length ()
+{
+	double e = 0;
+	for (uint i=0; i<N; i++) { r[i] = Dist(a[i],b[i]).length(); }
+	for (uint i=0; i<N; i++) { e = max(e, fabs(r[i] - hypot(double(a[i]),double(b[i]))) / hypot(double(a[i]),double(b[i]))); }
+	report("Dist::length()", measure([]{ for (uint i=0; i<N; i++) sink = Dist(a[i],b[i]).length(); }), e, "rel.");
+
+	// Fixed: inputs scaled into the Q16.16 range
+	static FixDist fd[N];
+	for (uint i=0; i<N; i++) { fd[i] = FixDist(Fixed(a[i]/4), Fixed(b[i]/4)); }
+	e = 0;
+	for (uint i=0; i<N; i++)
+	{
+		double ref = hypot(double(fd[i].dx), double(fd[i].dy));
+		e = max(e, fabs(double(fd[i].length()) - ref));
+	}
+	report("FixDist::length()", measure([]{ for (uint i=0; i<N; i++) sink = FLOAT(fd[i].length()); }), e, "abs.");
+}
+
+static void bench_inverse_sqrt ()
+{
+	// a[] are positions in the scanner range, here used as squared lengths:
+	static float x[N];
+	for (uint i=0; i<N; i++) { x[i] = a[i]*a[i] + 1; }
+
+	double e;
+	auto error = [&](float(*f)(float))
+	{
+		e = 0;
+		for (uint i=0; i<N; i++) { e = max(e, fabs(double(f(x[i])) * sqrt(double(x[i])) - 1)); }
+	};
+
+	error([](float x){ return 1.0f / sqrtf(x); });
+	report("1/sqrtf(x)", measure([]{ for (uint i=0; i<N; i++) sink = 1.0f / sqrtf(x[i]); }), e, "rel.");
+	error(q3_inverse_sqrt<0>);
+	report("q3_inverse_sqrt<0>", measure([]{ for (uint i=0; i<N; i++) sink = q3_inverse_sqrt<0>(x[i]); }), e, "rel.");
+	error(q3_inverse_sqrt<1>);
+	report("q3_inverse_sqrt<1>", measure([]{ for (uint i=0; i<N; i++) sink = q3_inverse_sqrt<1>(x[i]); }), e, "rel.");
+	error(q3_inverse_sqrt<2>);
+	report("q3_inverse_sqrt<2>", measure([]{ for (uint i=0; i<N; i++) sink = q3_inverse_sqrt<2>(x[i]); }), e, "rel.");
+	error(q3_inverse_sqrt<3>);
+	report("q3_inverse_sqrt<3>", measure([]{ for (uint i=0; i<N; i++) sink = q3_inverse_sqrt<3>(x[i]); }), e, "rel.");
+}
+
+static void bench_sin_cos ()
+{
+	// angles: a[] scaled to ±2pi
+	static FLOAT w[N];
+	for (uint i=0; i<N; i++) { w[i] = a[i] * FLOAT(2 * 3.14159265358979 / 0x8000); }
+
+	double e = 0;
+	for (uint i=0; i<N; i++) { e = max(e, fabs(double(sinf(w[i])) - sin(double(w[i])))); }
+	report("sinf()+cosf()", measure([]{ for (uint i=0; i<N; i++) sink = sinf(w[i]) + cosf(w[i]); }), e, "abs.");
+
+	report("sin()+cos() (double)", measure([]{ for (uint i=0; i<N; i++) sink = FLOAT(sin(double(w[i])) + cos(double(w[i]))); }), 0, nullptr);
+
+	e = 0;
+	for (uint i=0; i<N; i++)
+	{
+		FLOAT s, c;
+		fast_sincos(w[i], s, c);
+		e = max(e, max(fabs(double(s) - sin(double(w[i]))), fabs(double(c) - cos(double(w[i])))));
+	}
+	report("fast_sincos()", measure([]{ for (uint i=0; i<N; i++) { FLOAT s,c; fast_sincos(w[i],s,c); sink = s+c; } }), e, "abs.");
+
+	e = 0;
+	SinCosStepper st(1, FLOAT(2 * 3.14159265358979 / N));
+	for (uint i=0; i<N; i++, st.next())
+	{
+		double w = 1 + 2 * 3.14159265358979 / N * i;
+		e = max(e, max(fabs(double(st.sin) - sin(w)), fabs(double(st.cos) - cos(w))));
+	}
+	report("SinCosStepper::next()", measure([]
+	{
+		SinCosStepper st(1, FLOAT(2 * 3.14159265358979 / N));
+		for (uint i=0; i<N; i++) { st.next(); sink = st.sin + st.cos; }
+	}), e, "abs.");
+}
+
+static void bench_transform ()
+{
+	// p[] = points in font units, transformed into the scanner range:
+
+	Transformation t;
+	t.setRotationAndScale(FLOAT(0.3), 350);
+	t.setOffset(-8000, 5000);
+
+	Transformation tp = t;
+	tp.setProjection(FLOAT(0.0001), FLOAT(-0.0002));
+
+	static Transformation st, stp;
+	st = t; stp = tp;
+
+	report("Transformation::transformed()", measure([]{ for (uint i=0; i<N; i++) q[i] = st.transformed(p[i]); }), 0, nullptr);
+	report("Transformation::transform(N)",  measure([]{ st.transform(N,p,q); }), 0, nullptr);
+	report("projected transformed()",       measure([]{ for (uint i=0; i<N; i++) q[i] = stp.transformed(p[i]); }), 0, nullptr);
+	report("projected transform(N)",        measure([]{ stp.transform(N,p,q); }), 0, nullptr);
+
+	static FixTransformation ft;
+	static FixPoint fp[N], fq[N];
+	ft.set(Fixed(t.fx),Fixed(t.fy),Fixed(t.sx),Fixed(t.sy),Fixed(t.dx),Fixed(t.dy));
+	for (uint i=0; i<N; i++) { fp[i] = FixPoint(p[i]); }
+	ft.transform(N,fp,fq);
+	st.transform(N,p,q);
+	double e = 0;
+	for (uint i=0; i<N; i++) { e = max(e, max(fabs(double(fq[i].x) - double(q[i].x)), fabs(double(fq[i].y) - double(q[i].y)))); }
+	report("FixTransformation::transform(N)", measure([]{ ft.transform(N,fp,fq); }), e, "abs.");
+
+	// 3D: points in a unit cube, projected with a camera
+	static Point3 p3[N];
+	static ClipPoint cp[N];
+	static Matrix4 m4;
+	for (uint i=0; i<N; i++) { p3[i] = Point3(p[i].x / 20, p[i].y / 20, a[i] / 0x8000); }
+	Camera camera;
+	camera.position = Point3(0,0,-4);
+	m4 = camera.matrix() * Matrix4::rotationY(FLOAT(0.3));
+	report("Matrix4::transform(N)", measure([]{ m4.transform(N,p3,cp); }), 0, nullptr);
+}
+
+static void bench_draw_to ()
+{
+	// lines between the points in q[] with a typical drawing speed.
+	// op = 1 sample. error: sample count vs. ceil(length/speed) in double
+
+	static constexpr FLOAT speed = 100;
+	static uint samples = 0;
+	static Point pos0;
+
+	pos0 = q[N-1];
+	samples = 0;
+	int e = 0;
+	for (uint i=0; i<N; i++)
+	{
+		Point p0 = pos0;
+		uint n = step_line(pos0, q[i], speed);
+		samples += n;
+		double len = hypot(double(q[i].x) - double(p0.x), double(q[i].y) - double(p0.y));
+		e = max(e, abs(int(n) - int(ceil(len / speed))));
+	}
+
+	double ns = measure([]{ pos0 = q[N-1]; for (uint i=0; i<N; i++) step_line(pos0, q[i], speed); });
+	report("draw_to() sample stepping", ns * N / samples, e, "samples");
+}
+
+static void bench_queue ()
+{
+	static Queue<Data32,256> queue;
+
+	uint32 sum = 0;
+	for (uint i=0; i<N; i++) { queue.putc(uint32(i)); sum += queue.getc().u ^ i; }
+
+	report("Queue putc()+getc()", measure([]
+	{
+		for (uint i=0; i<N; i++) { queue.putc(a[i]); sink = queue.getc().f; }
+	}), sum, sum ? "errors" : nullptr);
+
+	report("Queue putc() N, getc() N", measure([]
+	{
+		for (uint i=0; i<N; i++) { queue.putc(a[i]); }
+		for (uint i=0; i<N; i++) { sink = queue.getc().f; }
+	}), 0, nullptr);
+}
+
+
+// ====================================================================
+//		run all
+// ====================================================================
+
+void runMathBenchmarks ()
+{
+	uint32 saved_random_state = random_state;		// don't change the game
+	srand32(0x2545f491u);
+
+	for (uint i=0; i<N; i++)
+	{
+		a[i] = rand(FLOAT(-0x8000), FLOAT(+0x7fff));
+		b[i] = rand(FLOAT(-0x8000), FLOAT(+0x7fff));
+		p[i] = Point(rand(FLOAT(-20),FLOAT(20)), rand(FLOAT(-20),FLOAT(20)));
+	}
+
+	printf("\nmath kernel benchmarks: %u inputs, min. %u ms per kernel\n", N, uint(min_time_ns / 1000000));
+	print_header();
+	bench_length();
+	bench_inverse_sqrt();
+	bench_sin_cos();
+	bench_transform();
+	bench_draw_to();
+	bench_queue();
+	printf("\n");
+
+	random_state = saved_random_state;
+}
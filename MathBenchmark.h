@@ -0,0 +1,22 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+
+
+// Micro benchmarks of the math kernels used by the game and by core1,
+// on the Pico (main menu key 'b') and on the host (LaseroidsMathBench).
+//
+// every kernel runs over the same 256 pseudo random inputs, which are the same on all platforms,
+// and is repeated until at least 20ms have passed.
+// the time is measured with time_us_64() on the Pico and with std::chrono on the host.
+// the report lists for every kernel:
+//   the time per operation in ns, on the Pico also in clock cycles,
+//   the max. error against a reference calculated in double.
+//
+// before and after an optimization: run it and compare the lines.
+
+extern void runMathBenchmarks ();
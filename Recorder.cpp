@@ -0,0 +1,90 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "Recorder.h"
+#include <stdio.h>
+#include <string.h>
+
+
+Recorder recorder;
+
+static const char rec_prefix[] = "REC:";
+static const char rec_header[] = "recording:";
+
+
+void Recorder::start (uint32 now_us)
+{
+	count = 0;
+	overflow = false;
+	recording = true;
+	put(TAG_START);
+	put(now_us);
+}
+
+void Recorder::input (uint input)
+{
+	if (recording) put(TAG_INPUT | (input & VALUE_MASK));
+}
+
+void Recorder::frame (uint32 elapsed_us)
+{
+	if (recording) put(TAG_FRAME | min(elapsed_us, VALUE_MASK));
+}
+
+void Recorder::stop (uint score)
+{
+	if (!recording) return;
+	put(TAG_END | (score & VALUE_MASK));
+	recording = false;
+}
+
+void Recorder::print () const
+{
+	// print recording in lines of up to 8 words
+	// the host only reads lines starting with "REC:" => the log file of stdout can be used
+
+	printf("%s %u words%s\n", rec_header, count, overflow ? " (truncated)" : "");
+
+	for (uint i=0; i<count; i++)
+	{
+		if (i%8 == 0) printf("%s", rec_prefix);
+		printf(" %08x", uint(data[i]));
+		if (i%8 == 7 || i+1 == count) printf("\n");
+	}
+}
+
+bool Recorder::read (FILE* file)
+{
+	// read recording printed by print()
+	// the overflow flag is restored from the header line
+	// returns false if no recording found
+
+	count = 0;
+	overflow = false;
+	recording = false;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		if (strncmp(line, rec_header, sizeof(rec_header)-1) == 0)
+		{
+			if (strstr(line, "(truncated)")) overflow = true;
+			continue;
+		}
+		if (strncmp(line, rec_prefix, sizeof(rec_prefix)-1) != 0) continue;
+
+		cptr p = line + sizeof(rec_prefix)-1;
+		uint word;
+		int n;
+		while (sscanf(p, " %8x%n", &word, &n) == 1)
+		{
+			put(word);
+			p += n;
+		}
+	}
+
+	return count != 0;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+
+
+/*	Recorder for Laseroids games:
+	records the random seed, the time of each frame and the input events
+	so that a game can be replayed exactly, e.g. on the host for benchmarks.
+
+	The recording is a list of uint32 words with a tag in the upper 3 bits:
+
+	TAG_START	followed by one raw word: time of the first frame, which is also the random seed
+	TAG_INPUT	input event for the next frame: Laseroids::Input
+	TAG_FRAME	time since previous frame [us]
+	TAG_END		final score
+*/
+class Recorder
+{
+public:
+	enum Tag : uint32
+	{
+		TAG_START = 1u << 29,
+		TAG_INPUT = 2u << 29,
+		TAG_FRAME = 3u << 29,
+		TAG_END   = 4u << 29,
+	};
+	static constexpr uint32 TAG_MASK   = 7u << 29;
+	static constexpr uint32 VALUE_MASK = ~TAG_MASK;
+
+	static constexpr uint capacity = 8 * 1024;	// 32 kB => ~2.5 minutes at 50 frames/sec
+
+	uint32 data[capacity];
+	uint count = 0;
+	bool recording = false;
+	bool overflow = false;		// recording was truncated
+
+	Recorder() = default;
+
+	void start (uint32 now_us);			// clear and start new recording
+	void input (uint input);
+	void frame (uint32 elapsed_us);
+	void stop (uint score);
+
+	void print () const;		// dump to stdout for replay on the host
+	bool read (FILE*);			// read dump, e.g. a log file of stdout
+	bool isComplete () const { return !overflow && count && (data[count-1] & TAG_MASK) == TAG_END; }
+
+private:
+	void put (uint32 word)
+	{
+		if (count < capacity) data[count++] = word;
+		else overflow = true;
+	}
+};
+
+
+extern Recorder recorder;
@@ -0,0 +1,83 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+
+TraceBuffer trace_buffer[2];
+volatile bool trace_enabled = false;
+
+static const char trc_prefix[] = "TRC:";
+
+static cstr id_names[TRACE_NUM_IDS] =
+{
+	"lost",
+	"simulate_begin",
+	"simulate_end",
+	"draw_begin",
+	"draw_end",
+	"optimize",
+	"core0_wait",
+	"core1_wait",
+	"new_object",
+	"delete_object",
+};
+
+
+cstr trace_id_name (uint id)
+{
+	return id < TRACE_NUM_IDS ? id_names[id] : "?";
+}
+
+uint trace_drain (uint max_events)
+{
+	// print up to max_events from both buffers
+	// one event per line: "TRC: time core|id a b"
+	// lost events are reported as TRACE_LOST events
+
+	static uint32 lost_reported[2] = {0,0};
+
+	uint n = 0;
+	for (uint core = 0; core < NELEM(trace_buffer); core++)
+	{
+		TraceBuffer& buffer = trace_buffer[core];
+
+		uint32 lost = buffer.lost;
+		if (lost != lost_reported[core])
+		{
+			printf("%s %08x %08x %08x %08x\n", trc_prefix, uint(time_us_32()), core<<16 | TRACE_LOST,
+				   uint(lost - lost_reported[core]), 0u);
+			lost_reported[core] = lost;
+		}
+
+		while (n < max_events && buffer.rp != buffer.wp)
+		{
+			__dmb();			// read the event after wp
+			const TraceEvent& e = buffer.events[buffer.rp & (TraceBuffer::capacity-1)];
+			printf("%s %08x %08x %08x %08x\n", trc_prefix, uint(e.time), uint(e.core)<<16 | e.id, uint(e.a), uint(e.b));
+			buffer.rp = buffer.rp + 1;
+			n++;
+		}
+	}
+	return n;
+}
+
+bool trace_parse (cstr line, TraceEvent& e)
+{
+	if (strncmp(line, trc_prefix, sizeof(trc_prefix)-1) != 0) return false;
+
+	uint time, id, a, b;
+	if (sscanf(line + sizeof(trc_prefix)-1, " %8x %8x %8x %8x", &time, &id, &a, &b) != 4) return false;
+
+	e.time = time;
+	e.core = uint16(id >> 16);
+	e.id   = uint16(id);
+	e.a    = a;
+	e.b    = b;
+	return true;
+}
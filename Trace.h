@@ -0,0 +1,112 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+
+/*	Trace log:
+	Binary events with a timestamp and two arguments in one buffer per core.
+	Each core writes only into its own buffer, so no locks are needed and writing an event takes only a few cycles.
+	Events are only recorded while trace_enabled is set. When a buffer is full, further events are lost and counted.
+
+	The events are kept in Ram while tracing and are printed when tracing is stopped:
+	printing while tracing would block the main loop for up to 100 ms per frame on the uart
+	and distort the timing which is traced.
+
+	The compile-time TRACE_LEVEL in settings.h selects which events are compiled in:
+	  0 = none
+	  1 = TRACE():         frames and waits
+	  2 = TRACE_VERBOSE(): also creation and deletion of objects
+
+	trace_drain() prints the events in lines starting with "TRC:"
+	which can be decoded on the host with LaseroidsTrace.
+*/
+
+enum TraceId : uint16
+{
+	TRACE_LOST,				// a: events lost because the buffer was full
+	TRACE_SIMULATE_BEGIN,	// --
+	TRACE_SIMULATE_END,		// a: simulation steps
+	TRACE_DRAW_BEGIN,		// --
+	TRACE_DRAW_END,			// a: level of detail
+	TRACE_OPTIMIZE,			// a: swaps in display list
+	TRACE_CORE0_WAIT,		// a: us waited for free space in the laser_queue
+	TRACE_CORE1_WAIT,		// a: us waited for data in the laser_queue
+	TRACE_NEW_OBJECT,		// a: 4 chars of name, b: address
+	TRACE_DELETE_OBJECT,	// a: 4 chars of name, b: address
+
+	TRACE_NUM_IDS
+};
+
+struct TraceEvent
+{
+	uint32 time;			// time_us_32()
+	uint16 id;				// TraceId
+	uint16 core;
+	uint32 a, b;			// arguments
+};
+
+class TraceBuffer
+{
+	// Note:
+	// put only on the own core
+	// get only in trace_drain()
+
+public:
+	static constexpr uint capacity = 1024;	// must be 2^N. 16 kB => ~3 sec. at 50 frames/sec
+
+	TraceEvent events[capacity];
+	volatile uint32 wp = 0;		// written by the core
+	volatile uint32 rp = 0;		// written by trace_drain()
+	volatile uint32 lost = 0;	// written by the core
+
+	void put (uint16 core, TraceId id, uint32 a, uint32 b)
+	{
+		uint32 w = wp;
+		if (w - rp >= capacity) { lost = lost + 1; return; }
+
+		TraceEvent& e = events[w & (capacity-1)];
+		e.time = time_us_32();
+		e.id   = id;
+		e.core = core;
+		e.a    = a;
+		e.b    = b;
+		__dmb();				// event must be complete before wp is incremented
+		wp = w + 1;
+	}
+};
+
+extern TraceBuffer trace_buffer[2];		// one per core
+extern volatile bool trace_enabled;
+
+inline void trace (TraceId id, uint32 a = 0, uint32 b = 0)
+{
+	if (!trace_enabled) return;
+	uint core = get_core_num();
+	trace_buffer[core].put(uint16(core), id, a, b);
+}
+
+inline uint32 trace_name (cstr name)
+{
+	// pack the first 4 chars of a name into the argument of an event
+
+	uint32 n = 0;
+	for (uint i=0; i<4 && name[i]; i++) { n |= uint32(uint8(name[i])) << (8*i); }
+	return n;
+}
+
+// disabled events are removed by the compiler but their arguments still count as used:
+#define TRACE(...)		   do { if (TRACE_LEVEL >= 1) trace(__VA_ARGS__); } while(0)
+#define TRACE_VERBOSE(...) do { if (TRACE_LEVEL >= 2) trace(__VA_ARGS__); } while(0)
+
+
+extern uint  trace_drain (uint max_events = ~0u);	// print up to max_events, returns number printed
+extern cstr  trace_id_name (uint id);				// for the decoder
+extern bool  trace_parse (cstr line, TraceEvent&);	// for the decoder: parse one line printed by trace_drain()
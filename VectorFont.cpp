@@ -0,0 +1,429 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "cdefs.h"
+#include "VectorFont.h"
+#include "vt_vector_font.h"			// constexpr int8 vt_font_data[];
+#include "vt_thin_font.h"			// constexpr int8 vt_thin_font_data[];
+
+static_assert(L == VT_STRAIGHT && R == VT_ROUNDED && E == VT_END, "VectorFont.h");
+
+
+// =====================================================================
+//				glyph index and metrics, calculated at compile time
+// =====================================================================
+
+// The strokes of each glyph are rearranged to minimize the blank jumps:
+// all orders and directions of the strokes are tried and closed strokes start at the nearest point.
+// the previous glyph is assumed to end left of the glyph and the next glyph to start right of it,
+// at half height and a few units away, which gave the best results for random text.
+// strokes which continue where the previous stroke ended with the same line type are joined.
+
+static constexpr uint  VT_MAX_STROKES = 4;		// per glyph
+static constexpr uint  VT_MAX_POINTS  = 16;		// per stroke
+static constexpr FLOAT VT_STROKE_COST = 4;		// laser delays of a stroke, in font units
+static constexpr int   VT_ENTRY_X = -3, VT_EXIT_DX = +3, VT_ENTRY_Y = 3;
+
+struct VtStroke
+{
+	int8  type;			// VT_STRAIGHT or VT_ROUNDED
+	uint8 count;		// number of points
+	int8  x[VT_MAX_POINTS], y[VT_MAX_POINTS];
+
+	constexpr bool closed() const { return count >= 3 && x[0] == x[count-1] && y[0] == y[count-1]; }
+};
+
+struct VtStrokes
+{
+	VtStroke stroke[VT_MAX_STROKES];
+	uint count;
+};
+
+static void vt_font_error (cstr) {}		// not constexpr: stops the compiler
+
+static constexpr FLOAT vt_sqrt (FLOAT a)
+{
+	// Newton's method. the distances in the font are < 16
+
+	if (a <= 0) return 0;
+	FLOAT x = a;
+	for (uint i=0; i<12; i++) { x = (x + a/x) / 2; }
+	return x;
+}
+
+static constexpr FLOAT vt_dist (int x1, int y1, int x2, int y2)
+{
+	return vt_sqrt(FLOAT((x2-x1)*(x2-x1) + (y2-y1)*(y2-y1)));
+}
+
+static constexpr VtStrokes vt_read_strokes (const int8* src, uint i)
+{
+	// i = index of the first stroke in src[]
+
+	VtStrokes s{};
+	while (src[i] > E)
+	{
+		if (s.count == VT_MAX_STROKES) vt_font_error("too many strokes");
+		VtStroke& k = s.stroke[s.count++];
+		k.type = src[i++];
+		while (src[i] < E)
+		{
+			if (k.count == VT_MAX_POINTS) vt_font_error("too many points");
+			k.x[k.count] = src[i++];
+			k.y[k.count++] = src[i++];
+		}
+	}
+	return s;
+}
+
+static constexpr VtStroke vt_reversed (const VtStroke& k)
+{
+	VtStroke r = k;
+	for (uint j=0; j<k.count; j++) { r.x[j] = k.x[k.count-1-j]; r.y[j] = k.y[k.count-1-j]; }
+	return r;
+}
+
+static constexpr VtStroke vt_rotated (const VtStroke& k, int x, int y)
+{
+	// closed stroke: start at the point nearest to x,y
+
+	uint n = k.count - 1u, best = 0;
+	int  best_d = 0x7fff;
+	for (uint j=0; j<n; j++)
+	{
+		int d = (k.x[j]-x)*(k.x[j]-x) + (k.y[j]-y)*(k.y[j]-y);
+		if (d < best_d) { best_d = d; best = j; }
+	}
+
+	VtStroke r = k;
+	for (uint j=0; j<=n; j++) { r.x[j] = k.x[(best+j)%n]; r.y[j] = k.y[(best+j)%n]; }
+	return r;
+}
+
+static constexpr VtStrokes vt_arrange (const VtStrokes& s, uint order, uint reverse)
+{
+	// order:   permutation in the factorial number system
+	// reverse: bit mask of strokes to draw reversed
+
+	uint idx[VT_MAX_STROKES] = {};
+	for (uint i=0; i<s.count; i++) { idx[i] = i; }
+
+	VtStrokes r{};
+	r.count = s.count;
+	int x = VT_ENTRY_X, y = VT_ENTRY_Y;
+
+	for (uint i=0; i<s.count; i++)
+	{
+		uint k = i + order % (s.count - i);
+		order /= s.count - i;
+		uint t = idx[i]; idx[i] = idx[k]; idx[k] = t;
+
+		VtStroke stroke = s.stroke[idx[i]];
+		if (reverse>>i & 1) stroke = vt_reversed(stroke);
+		if (stroke.closed()) stroke = vt_rotated(stroke,x,y);
+		r.stroke[i] = stroke;
+		x = stroke.x[stroke.count-1];
+		y = stroke.y[stroke.count-1];
+	}
+	return r;
+}
+
+static constexpr bool vt_joined (const VtStroke& a, const VtStroke& b)
+{
+	return a.type == b.type && a.x[a.count-1] == b.x[0] && a.y[a.count-1] == b.y[0];
+}
+
+static constexpr FLOAT vt_cost (const VtStrokes& s, int width)
+{
+	// blank jumps into the glyph, between the strokes and out of the glyph.
+
+	if (s.count == 0) return 0;
+
+	const VtStroke& first = s.stroke[0];
+	const VtStroke& last  = s.stroke[s.count-1];
+	FLOAT cost = vt_dist(VT_ENTRY_X, VT_ENTRY_Y, first.x[0], first.y[0])
+			   + vt_dist(last.x[last.count-1], last.y[last.count-1], width + VT_EXIT_DX, VT_ENTRY_Y);
+
+	for (uint i=1; i<s.count; i++)
+	{
+		const VtStroke& a = s.stroke[i-1];
+		const VtStroke& b = s.stroke[i];
+		if (vt_joined(a,b)) continue;
+		cost += vt_dist(a.x[a.count-1], a.y[a.count-1], b.x[0], b.y[0]) + VT_STROKE_COST;
+	}
+	return cost;
+}
+
+static constexpr VtStrokes vt_optimize (const VtStrokes& s, int width)
+{
+	uint orders = 1;
+	for (uint i=2; i<=s.count; i++) { orders *= i; }
+
+	VtStrokes best = s;
+	FLOAT best_cost = vt_cost(s,width);
+
+	for (uint order=0; order<orders; order++)
+	{
+		for (uint reverse=0; reverse < 1u<<s.count; reverse++)
+		{
+			VtStrokes r = vt_arrange(s,order,reverse);
+			FLOAT cost = vt_cost(r,width);
+			if (cost < best_cost) { best_cost = cost; best = r; }
+		}
+	}
+	return best;
+}
+
+template<uint NG, uint ND, uint NK>
+struct VectorFontData
+{
+	// the layout of a VectorFont:
+	VectorFont header;
+	VtGlyph    glyph[NG];
+	int8       data[ND];
+	VtKerning  kerning[NK+1];	// +1: no arrays of size 0
+};
+
+static constexpr uint vt_make_glyph (VtGlyph& g, int8* data, const int8* src, uint i, uint j)
+{
+	// i = index of the glyph's kerning masks in src[]
+	// j = index for the glyph's strokes in data[]
+	// returns the new j
+
+	g.lmask = uint8(src[i++]);
+	g.rmask = uint8(src[i++]);
+	g.index = uint16(j);
+
+	VtStrokes s = vt_read_strokes(src,i);
+
+	int8 right = 0;
+	for (uint n=0; n<s.count; n++)
+	{
+		for (uint p=0; p<s.stroke[n].count; p++) { if (s.stroke[n].x[p] > right) right = s.stroke[n].x[p]; }
+	}
+	g.width = int8(right + 1);
+
+	s = vt_optimize(s,g.width);
+
+	g.left = g.bottom = 127;
+	g.right = g.top = -128;
+
+	for (uint n=0; n<s.count; n++)
+	{
+		const VtStroke& k = s.stroke[n];
+		uint p = 0;
+		if (n && vt_joined(s.stroke[n-1],k)) p = 1;
+		else { data[j++] = k.type; g.strokes++; }
+
+		for (; p<k.count; p++)
+		{
+			int8 x = k.x[p], y = k.y[p];
+			data[j++] = x;
+			data[j++] = y;
+			g.points++;
+			if (x < g.left)   g.left = x;
+			if (x > g.right)  g.right = x;
+			if (y < g.bottom) g.bottom = y;
+			if (y > g.top)    g.top = y;
+			if (p) g.length += vt_dist(k.x[p-1], k.y[p-1], x, y);
+		}
+	}
+	data[j++] = E;
+
+	if (g.points == 0) g.left = g.bottom = g.right = g.top = 0;
+	return j;
+}
+
+static constexpr uint vt_next_glyph (const int8* src, uint i)
+{
+	i += 2;
+	while (src[i++] > E) { while (src[i] < E) i += 2; }
+	return i;
+}
+
+static constexpr uint vt_num_glyphs (const int8* src, uint size)
+{
+	uint n = 0;
+	for (uint i = 0; i < size; i = vt_next_glyph(src,i)) { n++; }
+	return n;
+}
+
+static constexpr uint vt_data_size (const int8* src, uint size)
+{
+	// the optimized strokes are never longer than the source without the kerning masks
+
+	return size - 2 * vt_num_glyphs(src,size);
+}
+
+template<uint NG, uint ND, uint NK>
+static constexpr VectorFontData<NG,ND,NK> vt_make_font (const int8* src, uint first_char, char default_char,
+														uint8 flags, const VtKerning* kerning)
+{
+	// src[] = glyphs for NG characters starting with first_char, as in vt_vector_font.h
+	// the remainder of data[] after the last glyph is filled with VT_END.
+
+	VectorFontData<NG,ND,NK> font{};
+	font.header.magic = VectorFont::MAGIC;
+	font.header.num_kerning = NK;
+	font.header.data_size = ND;
+	font.header.first_char = uint8(first_char);
+	font.header.num_glyphs = NG;
+	font.header.default_char = uint8(default_char);
+	font.header.flags = flags;
+
+	uint i = 0, j = 0;
+	for (uint n = 0; n < NG; n++)
+	{
+		j = vt_make_glyph(font.glyph[n], font.data, src, i, j);
+		i = vt_next_glyph(src,i);
+	}
+	while (j < ND) { font.data[j++] = E; }
+
+	for (uint n = 0; n < NK; n++)
+	{
+		font.kerning[n] = kerning[n];
+		if (n && uchar(kerning[n-1].left) * 256 + uchar(kerning[n-1].right) >=
+				 uchar(kerning[n].left) * 256 + uchar(kerning[n].right)) vt_font_error("kerning pairs not sorted");
+	}
+	return font;
+}
+
+
+// the original VT font:
+// the font starts with the space character. control codes are printed as space.
+
+static constexpr uint VT_NUM_GLYPHS = vt_num_glyphs(vt_font_data, NELEM(vt_font_data));
+static constexpr uint VT_DATA_SIZE  = vt_data_size(vt_font_data, NELEM(vt_font_data));
+
+static constexpr VectorFontData<VT_NUM_GLYPHS,VT_DATA_SIZE,0> vt_font_block =
+	vt_make_font<VT_NUM_GLYPHS,VT_DATA_SIZE,0>(vt_font_data, ' ', ' ', 0, nullptr);
+
+static_assert(VT_NUM_GLYPHS == 256 - ' ', "vt_vector_font.h: font data is incomplete");
+static_assert(vt_font_block.glyph[0].width == 4, "vt_vector_font.h: space");
+
+const VectorFont& vt_font = vt_font_block.header;
+
+
+// the thin font:
+
+static constexpr uint THIN_NUM_GLYPHS = vt_num_glyphs(vt_thin_font_data, NELEM(vt_thin_font_data));
+static constexpr uint THIN_DATA_SIZE  = vt_data_size(vt_thin_font_data, NELEM(vt_thin_font_data));
+static constexpr uint THIN_NUM_KERNING = NELEM(vt_thin_font_kerning);
+
+static constexpr VectorFontData<THIN_NUM_GLYPHS,THIN_DATA_SIZE,THIN_NUM_KERNING> vt_thin_font_block =
+	vt_make_font<THIN_NUM_GLYPHS,THIN_DATA_SIZE,THIN_NUM_KERNING>(vt_thin_font_data, ' ', '?', VectorFont::UPPERCASE_ONLY, vt_thin_font_kerning);
+
+static_assert(THIN_NUM_GLYPHS == 'Z' + 1 - ' ', "vt_thin_font.h: font data is incomplete");
+
+const VectorFont& vt_thin_font = vt_thin_font_block.header;
+
+
+// =====================================================================
+//							VectorFont
+// =====================================================================
+
+int VectorFont::kerning_pair (char left, char right) const
+{
+	// binary search in the kerning pairs
+
+	if (flags & UPPERCASE_ONLY)
+	{
+		if (left  >= 'a' && left  <= 'z') left  -= 'a'-'A';
+		if (right >= 'a' && right <= 'z') right -= 'a'-'A';
+	}
+
+	uint key = uchar(left) * 256 + uchar(right);
+	const VtKerning* k = kernings();
+	uint a = 0, e = num_kerning;
+
+	while (a < e)
+	{
+		uint m = (a + e) / 2;
+		uint mkey = uchar(k[m].left) * 256 + uchar(k[m].right);
+		if (mkey < key) a = m + 1;
+		else if (mkey > key) e = m;
+		else return k[m].dx;
+	}
+	return 0;
+}
+
+FLOAT VectorFont::printWidth (cstr s) const
+{
+	// calculate print width for string
+	// as printed by drawing command DrawText
+
+	int width = 0;
+	char prev = 0;
+
+	while (char c = *s++)
+	{
+		width += glyph(c).width + kerning(prev,c);
+		prev = c;
+	}
+	return FLOAT(width);
+}
+
+static bool check_strokes (const VtGlyph& glyph, const int8* data, uint data_size)
+{
+	// walk the strokes of a glyph like print_char() and CompiledText::compile():
+	// n * { VT_STRAIGHT|VT_ROUNDED, m * { x, y } }, VT_END  with m ≥ 1 and x,y < VT_END.
+	// the counts must match the glyph, because CompiledText allocates its buffer with them.
+
+	uint strokes = 0, points = 0;
+	uint i = glyph.index;
+
+	for (;;)
+	{
+		if (i >= data_size) return false;
+		int8 c = data[i++];
+		if (c == VT_END) break;
+		if (c != VT_STRAIGHT && c != VT_ROUNDED) return false;
+		strokes++;
+
+		do
+		{
+			if (i + 2 > data_size) return false;
+			if (data[i] >= VT_END || data[i+1] >= VT_END) return false;
+			i += 2;
+			points++;
+		}
+		while (i < data_size && data[i] < VT_END);
+	}
+
+	return strokes == glyph.strokes && points == glyph.points;
+}
+
+const VectorFont* VectorFont::load (const void* address, uint size)
+{
+	// check a font of size bytes which was written to flash or loaded into ram
+	// and return the font handle if it is valid.
+
+	if (size_t(address) & 3) return nullptr;
+	if (size < sizeof(VectorFont)) return nullptr;
+	const VectorFont* font = reinterpret_cast<const VectorFont*>(address);
+
+	if (font->magic != MAGIC) return nullptr;
+	if (font->num_glyphs == 0 || font->first_char + font->num_glyphs > 256) return nullptr;
+	if (uint8(font->default_char - font->first_char) >= font->num_glyphs) return nullptr;
+
+	// all parts must be inside size, the kerning pairs included:
+	if (sizeof(VectorFont) + font->num_glyphs * sizeof(VtGlyph) + font->data_size +
+		font->num_kerning * sizeof(VtKerning) > size) return nullptr;
+
+	const int8* data = font->data();
+	for (uint i=0; i<font->num_glyphs; i++)
+	{
+		if (!check_strokes(font->glyphs()[i], data, font->data_size)) return nullptr;
+	}
+
+	// the kerning pairs must be strictly sorted for the binary search in kerning_pair():
+	const VtKerning* k = font->kernings();
+	for (uint i=1; i<font->num_kerning; i++)
+	{
+		if (uchar(k[i-1].left) * 256 + uchar(k[i-1].right) >= uchar(k[i].left) * 256 + uchar(k[i].right)) return nullptr;
+	}
+	return font;
+}
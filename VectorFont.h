@@ -0,0 +1,97 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+
+
+// Vector fonts for XY2::printText() and CompiledText
+//
+// A font is one block of data in a binary format which is used in place, in flash (XIP) or in ram:
+//
+//   VectorFont  header
+//   VtGlyph     glyph[num_glyphs]			for the characters first_char … first_char+num_glyphs-1
+//   int8        data[data_size]			strokes of all glyphs
+//   VtKerning   kerning[num_kerning]		sorted by left and right
+//
+// the strokes of a glyph are n * { VT_STRAIGHT|VT_ROUNDED, m * { x, y } }, VT_END.
+// all sizes are in font units. the baseline is at y=0, capitals are 6 units high.
+// between 2 glyphs the print position is adjusted by +1 if their kerning masks overlap
+// and by the kerning pair for the 2 characters, if any.
+//
+// the compiled-in fonts are generated from glyph tables like vt_vector_font.h by the compiler.
+// other fonts, e.g. a copy of a compiled-in font in flash, must be checked by VectorFont::load()
+// which walks the strokes of all glyphs, so that print_char() and CompiledText never read outside of the font.
+
+// codes in the stroke data, as defined in vt_vector_font.h:
+static constexpr int8 VT_STRAIGHT = 127;	// straight line
+static constexpr int8 VT_ROUNDED  = 126;	// rounded line
+static constexpr int8 VT_END      = 125;	// end. must be lowest
+
+struct VtGlyph
+{
+	uint16 index;			// index of the first stroke in data[]
+	int8   width;			// print width (including +1 for line width but no spacing)
+	uint8  lmask, rmask;	// kerning masks
+	uint8  strokes;			// number of strokes (polylines)
+	uint8  points;			// number of points in all strokes
+	int8   left, bottom, right, top;	// bounding box
+	FLOAT  length;			// lit path length of all strokes, without the jumps between them
+};
+
+struct VtKerning
+{
+	char left, right;		// character pair
+	int8 dx;				// adjustment of the print position
+	int8 _padding;
+};
+
+struct VectorFont
+{
+	static constexpr uint32 MAGIC = 0x316e4656;	// "VFn1"
+	static constexpr uint8  UPPERCASE_ONLY = 1;	// flags: print lowercase letters as uppercase
+
+	uint32 magic;
+	uint16 num_kerning;
+	uint16 data_size;
+	uint8  first_char;
+	uint8  num_glyphs;
+	uint8  default_char;	// printed for characters which are not in the font
+	uint8  flags;
+
+	const VtGlyph*   glyphs () const   { return reinterpret_cast<const VtGlyph*>(this+1); }
+	const int8*      data () const     { return reinterpret_cast<const int8*>(glyphs() + num_glyphs); }
+	const VtKerning* kernings () const { return reinterpret_cast<const VtKerning*>(data() + data_size); }
+
+	const VtGlyph& glyph (char c) const
+	{
+		uint i = uchar(c);
+		if ((flags & UPPERCASE_ONLY) && i >= 'a' && i <= 'z') i -= 'a'-'A';
+		i -= first_char;
+		if (i >= num_glyphs) i = uint(default_char) - first_char;
+		return glyphs()[i];
+	}
+
+	const int8* strokes (const VtGlyph& g) const { return data() + g.index; }
+
+	int kerning (char left, char right) const	// adjustment of the print position between 2 characters
+	{
+		if (left == 0) return 0;
+		int dx = glyph(left).rmask & glyph(right).lmask ? 1 : 0;
+		return num_kerning ? dx + kerning_pair(left,right) : dx;
+	}
+
+	FLOAT printWidth (cstr s) const;
+	uint  size () const { return uint(reinterpret_cast<cuptr>(kernings() + num_kerning) - reinterpret_cast<cuptr>(this)); }
+
+	static const VectorFont* load (const void* address, uint size);	// check font in flash, returns nullptr if not valid
+
+private:
+	int kerning_pair (char left, char right) const;
+};
+
+extern const VectorFont& vt_font;		// the original VT font, proportional with kerning masks
+extern const VectorFont& vt_thin_font;	// a lighter font with fewer strokes, uppercase only
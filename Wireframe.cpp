@@ -0,0 +1,336 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include <string.h>
+#include <utility>
+#include "cdefs.h"
+#include "fast_trig.h"
+#include "Wireframe.h"
+
+
+// ====================================================================
+//		Matrix4
+// ====================================================================
+
+Matrix4 Matrix4::translation (FLOAT dx, FLOAT dy, FLOAT dz)
+{
+	Matrix4 z;
+	z.m[0][3] = dx;
+	z.m[1][3] = dy;
+	z.m[2][3] = dz;
+	return z;
+}
+
+Matrix4 Matrix4::scaling (FLOAT fx, FLOAT fy, FLOAT fz)
+{
+	Matrix4 z;
+	z.m[0][0] = fx;
+	z.m[1][1] = fy;
+	z.m[2][2] = fz;
+	return z;
+}
+
+Matrix4 Matrix4::rotationX (FLOAT rad)
+{
+	FLOAT sin, cos;
+	fast_sincos(rad, sin, cos);
+
+	Matrix4 z;
+	z.m[1][1] = cos; z.m[1][2] = -sin;
+	z.m[2][1] = sin; z.m[2][2] = cos;
+	return z;
+}
+
+Matrix4 Matrix4::rotationY (FLOAT rad)
+{
+	FLOAT sin, cos;
+	fast_sincos(rad, sin, cos);
+
+	Matrix4 z;
+	z.m[0][0] = cos;  z.m[0][2] = sin;
+	z.m[2][0] = -sin; z.m[2][2] = cos;
+	return z;
+}
+
+Matrix4 Matrix4::rotationZ (FLOAT rad)
+{
+	FLOAT sin, cos;
+	fast_sincos(rad, sin, cos);
+
+	Matrix4 z;
+	z.m[0][0] = cos; z.m[0][1] = -sin;
+	z.m[1][0] = sin; z.m[1][1] = cos;
+	return z;
+}
+
+Matrix4 Matrix4::perspective (FLOAT focal_length)
+{
+	Matrix4 z;
+	z.m[0][0] = focal_length;
+	z.m[1][1] = focal_length;
+	z.m[3][2] = 1;
+	z.m[3][3] = 0;
+	return z;
+}
+
+Matrix4 Matrix4::operator* (const Matrix4& q) const
+{
+	Matrix4 z;
+	for (uint i=0; i<4; i++)
+	for (uint j=0; j<4; j++)
+	{
+		z.m[i][j] = m[i][0] * q.m[0][j] + m[i][1] * q.m[1][j] + m[i][2] * q.m[2][j] + m[i][3] * q.m[3][j];
+	}
+	return z;
+}
+
+Point3 Matrix4::transformed (const Point3& p) const
+{
+	return Point3(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+				  m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+				  m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+}
+
+void Matrix4::transform (uint count, const Point3 in[], ClipPoint out[]) const
+{
+	// only the rows for x, y and w are calculated. the matrix is held in locals:
+
+	const FLOAT m00 = m[0][0], m01 = m[0][1], m02 = m[0][2], m03 = m[0][3];
+	const FLOAT m10 = m[1][0], m11 = m[1][1], m12 = m[1][2], m13 = m[1][3];
+	const FLOAT m30 = m[3][0], m31 = m[3][1], m32 = m[3][2], m33 = m[3][3];
+
+	for (uint i=0; i<count; i++)
+	{
+		const FLOAT x = in[i].x, y = in[i].y, z = in[i].z;
+		out[i].x = m00 * x + m01 * y + m02 * z + m03;
+		out[i].y = m10 * x + m11 * y + m12 * z + m13;
+		out[i].w = m30 * x + m31 * y + m32 * z + m33;
+	}
+}
+
+
+// ====================================================================
+//		Camera
+// ====================================================================
+
+Matrix4 Camera::matrix () const
+{
+	return Matrix4::perspective(focal_length) *
+		   Matrix4::rotationX(-pitch) *
+		   Matrix4::rotationY(-yaw) *
+		   Matrix4::translation(-position);
+}
+
+
+// ====================================================================
+//		Mesh
+// ====================================================================
+
+Mesh::Mesh (uint num_vertices, const Point3 vertices[]) :
+	num_vertices(num_vertices),
+	vertices(new Point3[num_vertices]),
+	clip(new ClipPoint[num_vertices]),
+	screen(new Point[num_vertices])
+{
+	assert(num_vertices <= 0x10000);
+	if (vertices) for (uint i=0; i<num_vertices; i++) { this->vertices[i] = vertices[i]; }
+}
+
+Mesh::~Mesh()
+{
+	delete[] vertices;
+	delete[] edges;
+	delete[] chains;
+	delete[] clip;
+	delete[] screen;
+	delete[] line;
+}
+
+void Mesh::addEdge (uint a, uint b)
+{
+	// add edge a-b if it is not yet in the mesh.
+	// linear search: this is done once when the mesh is created.
+
+	assert(a < num_vertices && b < num_vertices);
+	if (a == b) return;
+	if (a > b) std::swap(a,b);
+
+	for (uint i=0; i<num_edges; i++)
+	{
+		if (edges[i][0] == a && edges[i][1] == b) return;
+	}
+
+	if (num_edges == max_edges)
+	{
+		max_edges = max_edges ? max_edges * 2 : 16;
+		uint16 (*new_edges)[2] = new uint16[max_edges][2];
+		memcpy(new_edges, edges, num_edges * sizeof(*edges));
+		delete[] edges;
+		edges = new_edges;
+	}
+
+	edges[num_edges][0] = uint16(a);
+	edges[num_edges][1] = uint16(b);
+	num_edges++;
+
+	delete[] chains;
+	chains = nullptr;
+}
+
+void Mesh::addPolygon (uint count, const uint16 indexes[])
+{
+	for (uint i=0; i<count; i++)
+	{
+		addEdge(indexes[i], indexes[i+1 < count ? i+1 : 0]);
+	}
+}
+
+void Mesh::build_chains () const
+{
+	// sort the edges into chains which pass every edge once.
+	//
+	// a chain can only start or end at a vertex with an odd number of unused edges,
+	// or it is a closed loop. so chains are started at odd vertices first, and among these
+	// at the nearest to the end of the previous chain, then they are followed as long as possible.
+	// this is greedy and not an optimal Euler path, but most jumps are removed.
+
+	// edges per vertex:
+	uint* first = new uint[num_vertices+1];		// index in adj[]
+	uint* degree = new uint[num_vertices];		// number of unused edges
+	uint* adj = new uint[num_edges*2];			// edge indexes
+	bool* used = new bool[num_edges];
+
+	memset(degree, 0, num_vertices * sizeof(uint));
+	memset(used, 0, num_edges * sizeof(bool));
+	for (uint e=0; e<num_edges; e++) { degree[edges[e][0]]++; degree[edges[e][1]]++; }
+	first[0] = 0;
+	for (uint v=0; v<num_vertices; v++) { first[v+1] = first[v] + degree[v]; degree[v] = 0; }
+	for (uint e=0; e<num_edges; e++)
+	{
+		uint a = edges[e][0], b = edges[e][1];
+		adj[first[a] + degree[a]++] = e;
+		adj[first[b] + degree[b]++] = e;
+	}
+
+	// a chain of n edges needs n+2 entries, the end mark 1:
+	delete[] chains;
+	chains = new uint16[num_edges * 3 + 1];
+	uint16* p = chains;
+	max_chain = 0;
+
+	Point3 pos;
+	uint remaining = num_edges;
+	while (remaining)
+	{
+		// find the start vertex:
+		uint v = num_vertices;
+		bool v_odd = false;
+		FLOAT v_dist = 0;
+		for (uint i=0; i<num_vertices; i++)
+		{
+			if (degree[i] == 0) continue;
+			bool odd = degree[i] & 1;
+			FLOAT dist = (vertices[i] - pos).length();
+			if (v == num_vertices || (odd && !v_odd) || (odd == v_odd && dist < v_dist)) { v = i; v_odd = odd; v_dist = dist; }
+		}
+
+		// follow unused edges:
+		uint16* count = p++;
+		*p++ = uint16(v);
+		for (;;)
+		{
+			uint i = first[v];
+			while (i < first[v+1] && used[adj[i]]) i++;
+			if (i == first[v+1]) break;
+
+			uint e = adj[i];
+			used[e] = true;
+			remaining--;
+			degree[edges[e][0]]--;
+			degree[edges[e][1]]--;
+			v = edges[e][0] == v ? edges[e][1] : edges[e][0];
+			*p++ = uint16(v);
+		}
+
+		*count = uint16(p - count - 1);
+		max_chain = max(max_chain, uint(*count));
+		pos = vertices[v];
+	}
+	*p = 0;
+
+	delete[] line;
+	line = new Point[max_chain + 1];
+
+	delete[] first;
+	delete[] degree;
+	delete[] adj;
+	delete[] used;
+}
+
+template<typename F>
+void Mesh::walk (const Matrix4& matrix, FLOAT near, F draw_polyline) const
+{
+	// transform and project every vertex once,
+	// then pass the chains with the projected vertices to draw_polyline(count,points[]).
+	// the chains are split where they go behind the near plane.
+
+	if (!chains) build_chains();
+
+	matrix.transform(num_vertices, vertices, clip);
+	for (uint i=0; i<num_vertices; i++)
+	{
+		if (clip[i].w >= near) screen[i] = clip[i].projected();
+	}
+
+	auto intersection = [near](const ClipPoint& a, const ClipPoint& b)
+	{
+		FLOAT t = (near - a.w) / (b.w - a.w);
+		return Point((a.x + (b.x - a.x) * t) / near, (a.y + (b.y - a.y) * t) / near);
+	};
+
+	for (const uint16* p = chains; uint n = *p++; p += n)
+	{
+		uint count = 0;
+		if (clip[p[0]].w >= near) line[count++] = screen[p[0]];
+
+		for (uint i=1; i<n; i++)
+		{
+			const ClipPoint& a = clip[p[i-1]];
+			const ClipPoint& b = clip[p[i]];
+			if (b.w >= near)
+			{
+				if (a.w < near) line[count++] = intersection(b,a);
+				line[count++] = screen[p[i]];
+			}
+			else if (a.w >= near)
+			{
+				line[count++] = intersection(a,b);
+				draw_polyline(count, line);
+				count = 0;
+			}
+		}
+
+		if (count >= 2) draw_polyline(count, line);
+	}
+}
+
+void Mesh::draw (const Matrix4& matrix, const LaserSet& set, FLOAT near) const
+{
+	walk(matrix, near, [&set](uint count, const Point points[])
+	{
+		XY2::drawPolyLine(count, points, set);
+	});
+}
+
+uint Mesh::scan_cost (Point& pos, const Matrix4& matrix, const LaserSet& set, FLOAT near, const Transformation& t) const
+{
+	uint cost = 0;
+	walk(matrix, near, [&](uint count, const Point points[])
+	{
+		cost += XY2::costPolyLine(pos, count, points, set, POLYLINE_DEFAULT, t);
+	});
+	return cost;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "cdefs.h"
+#include "basic_geometry.h"
+#include "XY2.h"
+
+
+// 3D wireframe models.
+//
+// Mesh: indexed vertices and edges. an edge which is added twice, e.g. by two adjacent faces, is stored once.
+// before the first frame the edges are sorted into chains which pass every edge once,
+// starting at the vertices with an odd number of edges, so that the scanner makes as few jumps as possible.
+//
+// every frame all vertices are transformed once with a Matrix4 = projection * view * model
+// into clip coordinates, and not once per edge. then the chains are sent as poly lines to XY2.
+// edges which cross the near plane w = near are clipped, edges behind it are skipped.
+// the 2D result is transformed with the current transformation of XY2 like any other drawing.
+//
+// coordinates: x = right, y = up, z = into the screen. the camera looks along +z.
+
+
+struct Point3
+{
+	FLOAT x = 0, y = 0, z = 0;
+
+	Point3 () {}
+	Point3 (FLOAT x, FLOAT y, FLOAT z) : x(x), y(y), z(z) {}
+
+	Point3 operator+ (const Point3& q) const { return Point3(x+q.x, y+q.y, z+q.z); }
+	Point3 operator- (const Point3& q) const { return Point3(x-q.x, y-q.y, z-q.z); }
+	Point3 operator* (FLOAT f) const { return Point3(x*f, y*f, z*f); }
+	Point3 operator- () const { return Point3(-x, -y, -z); }
+
+	FLOAT length () const { return sqrt(x*x + y*y + z*z); }
+};
+
+
+struct ClipPoint	// a vertex after projection, before the division by w. z is not needed for a wireframe.
+{
+	FLOAT x, y, w;
+
+	Point projected () const { return Point(x/w, y/w); }
+};
+
+
+struct Matrix4
+{
+	FLOAT m[4][4];	// p' = m * (x,y,z,1)
+
+	Matrix4 () : m{{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}} {}
+
+	static Matrix4 translation (FLOAT dx, FLOAT dy, FLOAT dz);
+	static Matrix4 translation (const Point3& d) { return translation(d.x,d.y,d.z); }
+	static Matrix4 scaling (FLOAT f) { return scaling(f,f,f); }
+	static Matrix4 scaling (FLOAT fx, FLOAT fy, FLOAT fz);
+	static Matrix4 rotationX (FLOAT rad);
+	static Matrix4 rotationY (FLOAT rad);
+	static Matrix4 rotationZ (FLOAT rad);
+	static Matrix4 perspective (FLOAT focal_length);	// x' = x * focal_length / z, w = z
+
+	Matrix4 operator* (const Matrix4&) const;
+	Matrix4& operator*= (const Matrix4& q) { return *this = *this * q; }
+
+	Point3 transformed (const Point3&) const;		// without projection
+	void transform (uint count, const Point3 in[], ClipPoint out[]) const;
+};
+
+
+struct Camera
+{
+	Point3 position;
+	FLOAT  yaw = 0;					// rotation around the y axis
+	FLOAT  pitch = 0;				// rotation around the x axis
+	FLOAT  focal_length = 1000;		// in scanner units: a model of size 1 in distance 1 is 1000 units wide
+	FLOAT  near = FLOAT(0.1);		// near plane in model units
+
+	Matrix4 matrix () const;		// projection * view
+};
+
+
+class Mesh
+{
+public:
+	Mesh (uint num_vertices, const Point3 vertices[] = nullptr);
+	~Mesh();
+
+	Mesh (const Mesh&) = delete;
+	Mesh& operator= (const Mesh&) = delete;
+
+	void setVertex (uint i, const Point3& p) { vertices[i] = p; }
+	void addEdge (uint a, uint b);
+	void addPolygon (uint count, const uint16 indexes[]);	// closed: count edges
+
+	uint numVertices () const { return num_vertices; }
+	uint numEdges () const { return num_edges; }
+	const Point3& getVertex (uint i) const { return vertices[i]; }
+
+	void draw (const Matrix4&, const LaserSet&, FLOAT near = FLOAT(0.1)) const;
+	void draw (const Camera& camera, const Matrix4& model, const LaserSet& set) const { draw(camera.matrix() * model, set, camera.near); }
+	uint scan_cost (Point& pos, const Matrix4&, const LaserSet&, FLOAT near = FLOAT(0.1),
+					const Transformation& t = XY2::transformation0) const;
+
+private:
+	uint    num_vertices;
+	Point3* vertices;
+	uint    num_edges = 0;
+	uint    max_edges = 0;			// size of edges[]
+	uint16  (*edges)[2] = nullptr;	// a < b
+
+	// built on first use after the edges were modified:
+	mutable uint16* chains = nullptr;	// n * { count, count*index }, 0
+	mutable uint    max_chain = 0;		// max. count
+
+	// per frame:
+	ClipPoint* clip;				// transformed vertices
+	Point*     screen;				// projected vertices
+	mutable Point* line = nullptr;	// max_chain + 1 points for a poly line
+
+	void build_chains () const;
+	template<typename F> void walk (const Matrix4&, FLOAT near, F draw_polyline) const;
+};
@@ -13,7 +13,10 @@
 #include "hardware/pio_instructions.h"
 #include "pico/multicore.h"
 #include "cdefs.h"
+#include "fast_trig.h"
 #include "XY2.h"
+#include "VectorFont.h"
+#include "CompiledText.h"
 #include "XY2-100.pio.h"
 #include "hardware/pwm.h"
 #include "hardware/sync.h"
@@ -25,29 +28,6 @@
 static const FLOAT pi = FLOAT(3.1415926538);
 
 
-// application defined parameter sets, set 0 is used for jump
-#define FAST SCANNER_MAX_SPEED
-#define SLOW SCANNER_MAX_SPEED*2/3
-LaserSet laser_set[8] =
-{
-	#define A LASER_ON_DELAY
-	#define E LASER_OFF_DELAY
-	#define M LASER_MIDDLE_DELAY
-	#define J LASER_JUMP_DELAY
-
-	LaserSet{.speed=FAST, .pattern=0x003, .delay_a=0, .delay_m=0, .delay_e=J},	// jump
-	LaserSet{.speed=FAST, .pattern=0x3FF, .delay_a=A, .delay_m=M, .delay_e=E},	// fast straight
-	LaserSet{.speed=SLOW, .pattern=0x3FF, .delay_a=A, .delay_m=M, .delay_e=E},	// slow straight
-	LaserSet{.speed=FAST, .pattern=0x3FF, .delay_a=A, .delay_m=0, .delay_e=E},	// fast rounded
-	LaserSet{.speed=SLOW, .pattern=0x3FF, .delay_a=A, .delay_m=0, .delay_e=E},	// slow rounded
-
-	#undef E
-	#undef A
-	#undef M
-	#undef J
-};
-
-
 #define pio PIO_XY2
 
 //static
@@ -57,8 +37,13 @@ Point XY2::pos0{};
 LaserQueue laser_queue;    // command queue
 Transformation XY2::transformation0;		// transformation used by core0
 Transformation XY2::transformation1;		// transformation used by core1
+bool XY2::transform_on_core0 = false;		// core0 sends transformed points
+static bool transformation1_is_identity = true;	// core1: skip transformation
 Transformation XY2::transformation_stack[8];// transformation used by core0 and push stack
 uint XY2::transformation_stack_index = 0;
+uint32 XY2::texts_sent = 0;
+volatile uint32 XY2::texts_done = 0;
+XY2::Lissajous XY2::lissajous;				// core1: generator state
 static constexpr uint transformation_stack_mask = NELEM(XY2::transformation_stack) - 1;
 uint XY2::pwm_slice_num;
 int XY2::pwm_underruns;
@@ -85,26 +70,43 @@ uint XY2::delayed_laser_value (uint value)
 void XY2::moveTo (const Point& p)
 {
 	laser_queue.push(CMD_MOVETO);
-	laser_queue.push(p);
+	laser_queue.push(transformed(p));
 }
 
 void XY2::drawTo (const Point& p, const LaserSet& set)
 {
 	laser_queue.push(CMD_DRAWTO);
 	laser_queue.push(&set);
-	laser_queue.push(p);
+	laser_queue.push(transformed(p));
 }
 
 void XY2::drawLine (const Point& p1, const Point& p2, const LaserSet& set)
 {
 	laser_queue.push(CMD_LINE);
 	laser_queue.push(&set);
-	laser_queue.push(p1);
-	laser_queue.push(p2);
+	laser_queue.push(transformed(p1));
+	laser_queue.push(transformed(p2));
 }
 
 void XY2::drawRect (const Rect& rect, const LaserSet& set)
 {
+	if (transform_on_core0)
+	{
+		// the transformed rect is no longer a Rect:
+		// send the same moves as draw_rect() would do:
+
+		laser_queue.push(CMD_MOVETO);
+		laser_queue.push(transformed(rect.top_left()));
+		const Point corners[4] = { rect.top_right(), rect.bottom_right(), rect.bottom_left(), rect.top_left() };
+		for (uint i=0; i<4; i++)
+		{
+			laser_queue.push(CMD_LINETO);
+			laser_queue.push(&set);
+			laser_queue.push(transformed(corners[i]));
+		}
+		return;
+	}
+
 	laser_queue.push(CMD_RECT);
 	laser_queue.push(&set);
 	laser_queue.push(rect);
@@ -116,17 +118,73 @@ void XY2::drawEllipse (const Rect& bbox, FLOAT angle, uint steps, const LaserSet
 	FLOAT fx = bbox.width()/2;
 	FLOAT fy = bbox.height()/2;
 
-	FLOAT step = 2*pi / FLOAT(steps);
+	SinCosStepper a(angle, 2*pi / FLOAT(steps));
 
-	drawPolyLine(steps,[center,fx,fy,step,&angle]()
+	drawPolyLine(steps,[center,fx,fy,&a]()
 	{
-		FLOAT a = angle;
-		angle += step;
-		return center + Dist(fx*cos(a),fy*sin(a));
+		Point p = center + Dist(fx*a.cos,fy*a.sin);
+		a.next();
+		return p;
 	},
 	set, POLYLINE_CLOSED);
 }
 
+void XY2::drawArc (const Point& center, FLOAT radius_x, FLOAT radius_y, FLOAT angle0, FLOAT sweep, const LaserSet& set)
+{
+	// CMD_ARC, LaserSet, Point, 2*FLOAT radius, FLOAT angle0, FLOAT sweep
+
+	// curves are always transformed by core1:
+	if (transform_on_core0) send_transformation();
+
+	laser_queue.push(CMD_ARC);
+	laser_queue.push(&set);
+	laser_queue.push(center);
+	laser_queue.push(radius_x);
+	laser_queue.push(radius_y);
+	laser_queue.push(angle0);
+	laser_queue.push(sweep);
+
+	if (transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
+}
+
+void XY2::drawCubic (const Point& p0, const Point& p1, const Point& p2, const Point& p3, const LaserSet& set)
+{
+	// CMD_CUBIC, LaserSet, 4*Point
+
+	// curves are always transformed by core1:
+	if (transform_on_core0) send_transformation();
+
+	laser_queue.push(CMD_CUBIC);
+	laser_queue.push(&set);
+	laser_queue.push(p0);
+	laser_queue.push(p1);
+	laser_queue.push(p2);
+	laser_queue.push(p3);
+
+	if (transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
+}
+
+void XY2::drawLissajous (uint count, FLOAT x_scale, FLOAT y_scale, FLOAT x_step,
+						  FLOAT f_ratio_center, FLOAT f_ratio_scale, FLOAT f_ratio_step, const LaserSet& set)
+{
+	// CMD_LISSAJOUS, LaserSet, n, 2*FLOAT scale, FLOAT x_step, 3*FLOAT f_ratio center, scale and step
+
+	// generated points are always transformed by core1:
+	if (transform_on_core0) send_transformation();
+
+	laser_queue.push(CMD_LISSAJOUS);
+	laser_queue.push(&set);
+	laser_queue.push(count);
+	laser_queue.push(x_scale);
+	laser_queue.push(y_scale);
+	laser_queue.push(x_step);
+	laser_queue.push(f_ratio_center);
+	laser_queue.push(f_ratio_scale);
+	laser_queue.push(f_ratio_step);
+
+	if (transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
+}
+
 void XY2::drawPolyLine (uint count, std::function<Point()> nextPoint, const LaserSet& set,
 						PolyLineOptions flags)
 {
@@ -134,7 +192,10 @@ void XY2::drawPolyLine (uint count, std::function<Point()> nextPoint, const Lase
 	laser_queue.push(&set);
 	laser_queue.push(flags);
 	laser_queue.push(count);
-	for (uint i=0; i<count; i++) laser_queue.push(nextPoint());
+	if (transform_on_core0)
+		for (uint i=0; i<count; i++) laser_queue.push(transformation0.transformed(nextPoint()));
+	else
+		for (uint i=0; i<count; i++) laser_queue.push(nextPoint());
 }
 
 void XY2::drawPolyLine (uint count, const Point points[], const LaserSet& set,
@@ -144,7 +205,19 @@ void XY2::drawPolyLine (uint count, const Point points[], const LaserSet& set,
 	laser_queue.push(&set);
 	laser_queue.push(flags);
 	laser_queue.push(count);
-	for (uint i=0; i<count; i++) laser_queue.push(points[i]);
+	if (transform_on_core0)
+	{
+		// transform in chunks with the batch kernel:
+		Point buffer[16];
+		for (uint i=0; i<count; i+=NELEM(buffer))
+		{
+			uint n = min(count-i, uint(NELEM(buffer)));
+			transformation0.transform(n, points+i, buffer);
+			for (uint j=0; j<n; j++) laser_queue.push(buffer[j]);
+		}
+	}
+	else
+		for (uint i=0; i<count; i++) laser_queue.push(points[i]);
 }
 
 void XY2::drawPolygon (uint count, std::function<Point()> nextPoint, const LaserSet& set)
@@ -157,85 +230,100 @@ void XY2::drawPolygon (uint count, const Point points[], const LaserSet& set)
 	drawPolyLine(count,points,set,POLYLINE_CLOSED);
 }
 
-#include "vt_vector_font.h"			// int8 vt_font_data[];
-
-static uint vt_font_col1[256];		// index in vt_font_data[]
-static int8 vt_font_width[256];		// character print width (including +1 for line width but no spacing)
-
-
-static void vt_init_vector_font()
-{
-	for (uint i = 0, c=' '; c<NELEM(vt_font_col1) && i<NELEM(vt_font_data); c++)
-	{
-		vt_font_col1[c] = i;
-		i += 2;						// left-side mask and right-side mask
-
-		int8 width = 0;
-		while (vt_font_data[i++] > E)
-		{
-			while (vt_font_data[i] < E)
-			{
-				width = max(width,vt_font_data[i]);
-				i += 2;
-			}
-		}
-		vt_font_width[c] = width + 1;
-
-		assert(vt_font_data[i-1] == E);
-	}
-}
-
-
-FLOAT printWidth (cstr s)
-{
-	// calculate print width for string
-	// as printed by drawing command DrawText
-
-	int width = 0;
-	uint8 mask = 0;
-
-	while (uint8 c = uint8(*s++))
-	{
-		width += vt_font_width[c];
-		int8* p = vt_font_data + vt_font_col1[c];
-		if (mask & uint8(*p)) width++;	// +1 if glyphs would touch
-		mask = uint8(*(p+1));			// remember for next
-	}
-	return FLOAT(width);
-}
-
 void XY2::printText (Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered,
-					 const LaserSet& straight, const LaserSet& rounded)
+					 const LaserSet& straight, const LaserSet& rounded, const VectorFont& font)
 {
-	// CMD_PRINT_TEXT, 2*LaserSet, Point, 2*FLOAT, n*char, 0
+	// CMD_PRINT_TEXT, 2*LaserSet, VectorFont, Point, 2*FLOAT, n*char, 0
 
-	if (centered) start.x -= printWidth(text) * scale_x / 2;
+	if (centered) start.x -= font.printWidth(text) * scale_x / 2;
+
+	// glyphs are always transformed by core1:
+	if (transform_on_core0) send_transformation();
 
 	laser_queue.push(CMD_PRINT_TEXT);
 	laser_queue.push(&straight);
 	laser_queue.push(&rounded);
+	laser_queue.push(&font);
 	laser_queue.push(start);
 	laser_queue.push(scale_x);
 	laser_queue.push(scale_y);
 	char c; do { laser_queue.push(c = *text++); } while (c);
+
+	if (transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
 }
 
+void XY2::drawText (const CompiledText& text)
+{
+	// CMD_DRAW_TEXT, CompiledText
 
-void XY2::update_transformation ()
+	// glyphs are always transformed by core1:
+	if (transform_on_core0) send_transformation();
+
+	laser_queue.push(CMD_DRAW_TEXT);
+	laser_queue.push(&text);
+	text.last_drawn = ++texts_sent;
+
+	if (transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
+}
+
+
+void XY2::send_transformation ()
 {
 	static_assert (sizeof(Data32)==sizeof(FLOAT), "booboo");
 	laser_queue.push(transformation0.is_projected ? CMD_SET_TRANSFORMATION_3D : CMD_SET_TRANSFORMATION);
 	uint n = transformation0.is_projected ? 9 : 6;
-	while (laser_queue.free() < n) { gpio_put(LED_CORE0_IDLE,1); }
-	gpio_put(LED_CORE0_IDLE,0);
+	if (laser_queue.free() < n) laser_queue.wait_free(n);
 	Data32* data = reinterpret_cast<Data32*>(&transformation0);
 	laser_queue.write(data,n);
 }
 
+void XY2::update_transformation ()
+{
+	// if core0 transforms the points then core1 keeps the identity transformation:
+	if (!transform_on_core0) send_transformation();
+}
+
 void XY2::resetTransformation()
 {
 	transformation0.reset();
-	laser_queue.push(CMD_RESET_TRANSFORMATION);
+	if (!transform_on_core0) laser_queue.push(CMD_RESET_TRANSFORMATION);
+}
+
+void XY2::setTransformOnCore0 (bool f)
+{
+	if (f == transform_on_core0) return;
+	transform_on_core0 = f;
+
+	if (f) laser_queue.push(CMD_RESET_TRANSFORMATION);	// core1 uses identity from now on
+	else send_transformation();							// core1 uses the current transformation
+}
+
+void XY2::balanceLoad()
+{
+	// select which core transforms the points in the next frame.
+	// this should be called once per frame by core0.
+	//
+	// core0 waits for free space in the queue => core1 is the bottleneck => core0 transforms.
+	// core1 waits for data in the queue       => core0 is the bottleneck => core1 transforms.
+	// the difference must exceed 1/16 of the frame time to switch.
+
+	static uint32 last_time = 0;
+	static uint32 last_core0_wait = 0;
+	static uint32 last_core1_wait = 0;
+
+	uint32 now = time_us_32();
+	uint32 core0_wait = laser_queue.core0_wait_us;
+	uint32 core1_wait = laser_queue.core1_wait_us;
+
+	uint32 threshold = (now - last_time) / 16;
+	int32  delta = int32((core0_wait - last_core0_wait) - (core1_wait - last_core1_wait));
+
+	last_time = now;
+	last_core0_wait = core0_wait;
+	last_core1_wait = core1_wait;
+
+	if (delta > int32(threshold)) setTransformOnCore0(true);
+	else if (-delta > int32(threshold)) setTransformOnCore0(false);
 }
 
 void XY2::pushTransformation()
@@ -448,9 +536,6 @@ void XY2::init()
 	gpio_set_function(gpio, GPIO_FUNC_PWM);
 	gpio_set_dir(gpio,GPIO_IN);
 	pwm_underruns = pwm_get_counter(pwm_slice_num);
-
-	// misc.:
-	vt_init_vector_font();
 }
 
 void __no_inline_not_in_flash_func(suspend_no_flash) ()
@@ -472,6 +557,11 @@ void XY2::resume()
 	do { __sev(); } while (core1_suspended);
 }
 
+void XY2::waitIdle()
+{
+	while (laser_queue.avail()) {}
+}
+
 void XY2::worker()
 {
 	while (laser_queue.avail()) (void)laser_queue.pop();
@@ -500,6 +590,10 @@ void XY2::worker()
 	{
 		if (core1_suspend)
 		{
+			// switch off the laser before the scanner stops: the laser values are delayed by laser_delay_size samples.
+			// the PIO repeats the last sample while core1 is suspended.
+			for (uint i=0; i<=laser_delay_size; i++) { send_data_blocking(pos0, 0x000); }
+
 			uint old_state = save_and_disable_interrupts();
 			suspend_no_flash();
 			restore_interrupts(old_state);
@@ -562,40 +656,86 @@ void XY2::worker()
 			draw_polyline(count, [](){return laser_queue.pop_Point();}, *set, flags);
 			continue;
 		}
-		case CMD_PRINT_TEXT: // 	2*LaserSet, Point, 2*FLOAT, n*char, 0
+		case CMD_PRINT_TEXT: // 	2*LaserSet, VectorFont, Point, 2*FLOAT, n*char, 0
 		{
 			const LaserSet* straight = laser_queue.pop().set;
 			const LaserSet* rounded  = laser_queue.pop().set;
+			const VectorFont* font   = laser_queue.pop().font;
 			Point start   = laser_queue.pop_Point();
 			FLOAT scale_x = laser_queue.pop().f;
 			FLOAT scale_y = laser_queue.pop().f;
 
-			uint8 rmask = 0;
+			char prev = 0;
 			while (char c = char(laser_queue.pop().u))
 			{
-				print_char (start, scale_x, scale_y, *straight, *rounded, rmask, c);
+				print_char (start, scale_x, scale_y, *straight, *rounded, *font, prev, c);
 			}
 			continue;
 		}
+		case CMD_DRAW_TEXT:	// CompiledText
+		{
+			const CompiledText* text = laser_queue.pop().text;
+			draw_text(text->getStrokes());
+			texts_done++;
+			continue;
+		}
+		case CMD_ARC:		// LaserSet, Point, 2*FLOAT radius, FLOAT angle0, FLOAT sweep
+		{
+			const LaserSet* set = laser_queue.pop().set;
+			Point center = laser_queue.pop_Point();
+			FLOAT rx     = laser_queue.pop().f;
+			FLOAT ry     = laser_queue.pop().f;
+			FLOAT angle0 = laser_queue.pop().f;
+			FLOAT sweep  = laser_queue.pop().f;
+			draw_curve([=](FLOAT t){ return arc_point(center,rx,ry,angle0,sweep,t); }, *set);
+			continue;
+		}
+		case CMD_CUBIC:		// LaserSet, 4*Point
+		{
+			const LaserSet* set = laser_queue.pop().set;
+			Point p0 = laser_queue.pop_Point();
+			Point p1 = laser_queue.pop_Point();
+			Point p2 = laser_queue.pop_Point();
+			Point p3 = laser_queue.pop_Point();
+			draw_curve([=](FLOAT t){ return cubic_point(p0,p1,p2,p3,t); }, *set);
+			continue;
+		}
+		case CMD_LISSAJOUS:	// LaserSet, n, 2*FLOAT scale, FLOAT x_step, 3*FLOAT f_ratio center, scale and step
+		{
+			const LaserSet* set = laser_queue.pop().set;
+			uint count = laser_queue.pop().u;
+			FLOAT x_scale = laser_queue.pop().f;
+			lissajous.setScales(x_scale, laser_queue.pop().f);
+			FLOAT x_step = laser_queue.pop().f;
+			lissajous.f_ratio_center = laser_queue.pop().f;
+			lissajous.f_ratio_scale  = laser_queue.pop().f;
+			FLOAT f_ratio_step = laser_queue.pop().f;
+			lissajous.setSteps(x_step, f_ratio_step);
+			draw_polyline(count, [](){ return lissajous.next(); }, *set, POLYLINE_INFINITE);
+			continue;
+		}
 		case CMD_RESET_TRANSFORMATION:	// --
 		{
 			transformation1.reset();
+			transformation1_is_identity = true;
 			continue;
 		}
 		case CMD_SET_TRANSFORMATION:		// fx fy sx sy dx dy
 		{
-			while (laser_queue.avail()<6) {} // __wfi
+			if (laser_queue.avail()<6) laser_queue.wait_avail(6);
 			Data32* dest = reinterpret_cast<Data32*>(&transformation1);
 			laser_queue.read(dest,6);
 			transformation1.is_projected = false;
+			transformation1_is_identity = false;
 			continue;
 		}
 		case CMD_SET_TRANSFORMATION_3D:		// fx fy sx sy dx dy px py pz
 		{
-			while (laser_queue.avail()<9) {} // __wfi
+			if (laser_queue.avail()<9) laser_queue.wait_avail(9);
 			Data32* dest = reinterpret_cast<Data32*>(&transformation1);
 			laser_queue.read(dest,9);
 			transformation1.is_projected = true;
+			transformation1_is_identity = false;
 			continue;
 		}
 		}
@@ -618,20 +758,17 @@ void __not_in_flash_func(XY2::draw_to) (Point dest, FLOAT speed, uint laser_on_p
 	// thereafter use laser_on_pattern
 	// at end of line wait delay
 
-	transformation1.transform(dest);
+	if (!transformation1_is_identity) transformation1.transform(dest);
 
-	Dist dist = dest - pos0;
-	FLOAT line_length = dist.length();			// SQRT
-	Dist step = dist * (speed / line_length);
+	LineStepper line(pos0, dest, speed);
 
 	if (laser_on_delay)
 	{
 		uint laser_off_pattern = laser_set[0].pattern;
 
-		while (line_length > speed)
+		while (line.next())
 		{
-			line_length -= speed;
-			send_data_blocking(pos0+step, laser_off_pattern);
+			send_data_blocking(pos0+line.step, laser_off_pattern);
 			if (--laser_on_delay == 0) goto a;
 		}
 
@@ -649,10 +786,9 @@ void __not_in_flash_func(XY2::draw_to) (Point dest, FLOAT speed, uint laser_on_p
 	}
 	else
 	{
-		a: while (line_length > speed)
+		a: while (line.next())
 		{
-			line_length -= speed;
-			send_data_blocking(pos0+step, laser_on_pattern);
+			send_data_blocking(pos0+line.step, laser_on_pattern);
 		}
 
 		if (pos0 != dest)
@@ -711,6 +847,72 @@ void __not_in_flash_func(XY2::draw_polyline) (uint count, std::function<Point()>
 	if (closed) draw_to(start,speed,laser_on_pattern,laser_on_delay,set.delay_e);
 }
 
+template<typename CURVE>
+void __not_in_flash_func(XY2::draw_curve) (CURVE curve, const LaserSet& set)
+{
+	// draw a curve: curve(t) returns the points for t = 0 … 1 before the transformation.
+	//
+	// the curve is divided into CURVE_SEGMENTS segments with equal steps of t and the lengths of their
+	// chords after the transformation are summed up. then the samples are distributed evenly along this length
+	// => the samples are set.speed apart or a little less, except for the small difference between chord and arc.
+	// the samples are sent directly, there is no delay at the segment boundaries.
+	// at the start the laser is off for delay_a samples and at the end there are delay_e samples.
+
+	move_to(curve(0));
+
+	auto transformed = [](Point p)
+	{
+		if (!transformation1_is_identity) transformation1.transform(p);
+		return p;
+	};
+
+	// chord lengths:
+	FLOAT len[CURVE_SEGMENTS+1];
+	len[0] = 0;
+	Point p0 = pos0;
+	for (uint k=1; k<=CURVE_SEGMENTS; k++)
+	{
+		Point p1 = transformed(curve(FLOAT(k) / CURVE_SEGMENTS));
+		len[k] = len[k-1] + (p1 - p0).length();
+		p0 = p1;
+	}
+
+	const uint laser_off_pattern = laser_set[0].pattern;
+	uint laser_on_delay = set.delay_a;
+	auto send = [&](const Point& p)
+	{
+		send_data_blocking(p, laser_on_delay ? laser_off_pattern : set.pattern);
+		if (laser_on_delay) laser_on_delay--;
+	};
+
+	const FLOAT length = len[CURVE_SEGMENTS];
+	const uint n = uint(ceil(length / set.speed));
+
+	uint k = 1;
+	for (uint i=1; i<n; i++)
+	{
+		FLOAT s = length * FLOAT(i) / FLOAT(n);
+		while (len[k] < s && k < CURVE_SEGMENTS) k++;
+		FLOAT t = FLOAT(k-1) + (s - len[k-1]) / (len[k] - len[k-1]);
+		send(transformed(curve(t / CURVE_SEGMENTS)));
+	}
+	if (n) send(p0);
+
+	for (uint i=0; i<set.delay_e; i++) { send(p0); }
+}
+
+void XY2::draw_text (const Data32* p)
+{
+	// draw the strokes of a CompiledText:
+	// n * { LaserSet*, count, count*Point }, nullptr
+
+	while (const LaserSet* set = p++->set)
+	{
+		uint count = p++->u;
+		draw_polyline(count, [&p](){ Point pt(p[0].f,p[1].f); p += 2; return pt; }, *set, POLYLINE_DEFAULT);
+	}
+}
+
 void XY2::draw_line (const Point& start, const Point& dest, const LaserSet& set)
 {
 	move_to(start);
@@ -726,19 +928,20 @@ void XY2::draw_rect (const Rect& bbox, const LaserSet& set)
 	line_to(bbox.top_left(), set);
 }
 
-void XY2::print_char (Point& p0, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded, uint8& rmask, char c)
+void XY2::print_char (Point& p0, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded,
+					  const VectorFont& font, char& prev, char c)
 {
-	int8* p = vt_font_data + vt_font_col1[uchar(c)];
+	const VtGlyph& glyph = font.glyph(c);
+	const int8* p = font.strokes(glyph);
 
-	uint lmask = uint8(*p++);
-	if (rmask & lmask) p0.x += scale_x;		// apply kerning
-	rmask = uint8(*p++);					// for next kerning
+	p0.x += font.kerning(prev,c) * scale_x;		// apply kerning
+	prev = c;									// for next kerning
 
-	while (*p != E)
+	while (*p != VT_END)
 	{
 		int line_type = *p++;
 
-		const LaserSet& set = line_type == L ? straight : rounded;
+		const LaserSet& set = line_type == VT_STRAIGHT ? straight : rounded;
 
 		Point pt;
 		pt.x = p0.x + *p++ * scale_x;
@@ -746,15 +949,15 @@ void XY2::print_char (Point& p0, FLOAT scale_x, FLOAT scale_y, const LaserSet& s
 		move_to(pt);
 
 		uint delay_a = set.delay_a;
-		while (*p < E)
+		while (*p < VT_END)
 		{
 			pt.x = p0.x + *p++ * scale_x;
 			pt.y = p0.y + *p++ * scale_y;
-			draw_to(pt, set.speed, set.pattern, delay_a, *p<E ? set.delay_m : set.delay_e);
+			draw_to(pt, set.speed, set.pattern, delay_a, *p<VT_END ? set.delay_m : set.delay_e);
 		}
 	}
 
-	p0.x += vt_font_width[uchar(c)] * scale_x;	// update print position
+	p0.x += glyph.width * scale_x;	// update print position
 }
 
 
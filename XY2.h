@@ -7,12 +7,16 @@
 #pragma once
 
 #include "hardware/pio.h"
+#include "hardware/timer.h"
 #include "cdefs.h"
 #include "basic_geometry.h"
 #include <functional>
 #include "Queue.h"
+#include "Trace.h"
+#include "VectorFont.h"
 #include "pico/multicore.h"
 
+class CompiledText;
 
 struct LaserSet
 {
@@ -29,6 +33,33 @@ static constexpr LaserSet& fast_rounded  = laser_set[3];	// ""
 static constexpr LaserSet& slow_rounded  = laser_set[4];	// ""
 
 
+// LineStepper: the sample stepping of XY2::draw_to().
+// next() advances by one step of size speed while the remaining length > speed,
+// the caller sends start + n * step and then dest, if it is not yet there.
+class LineStepper
+{
+public:
+	Dist step;
+
+	LineStepper (const Point& start, const Point& dest, FLOAT speed) :
+		length((dest - start).length()),		// SQRT
+		speed(speed)
+	{
+		step = (dest - start) * (speed / length);
+	}
+
+	bool next ()
+	{
+		if (!(length > speed)) return false;
+		length -= speed;
+		return true;
+	}
+
+private:
+	FLOAT length, speed;
+};
+
+
 enum DrawCmd
 {
 	CMD_END = 0,	// arguments:
@@ -38,7 +69,11 @@ enum DrawCmd
 	CMD_LINE,       // LaserSet, 2*Point
 	CMD_RECT,       // LaserSet, Rect
 	CMD_POLYLINE,   // LaserSet, flags, n, n*Point
-	CMD_PRINT_TEXT,	// 2*LaserSet, Point, 2*FLOAT, n*char, 0
+	CMD_PRINT_TEXT,	// 2*LaserSet, VectorFont, Point, 2*FLOAT, n*char, 0
+	CMD_DRAW_TEXT,	// CompiledText
+	CMD_ARC,		// LaserSet, Point, 2*FLOAT radius, FLOAT angle0, FLOAT sweep
+	CMD_CUBIC,		// LaserSet, 4*Point
+	CMD_LISSAJOUS,	// LaserSet, n, 2*FLOAT scale, FLOAT x_step, 3*FLOAT f_ratio center, scale and step
 
 	CMD_RESET_TRANSFORMATION,	// --
 	CMD_SET_TRANSFORMATION,		// fx fy sx sy dx dy
@@ -48,6 +83,8 @@ union Data32
 {
 	DrawCmd cmd;
 	const LaserSet* set;
+	const CompiledText* text;
+	const VectorFont* font;
 	FLOAT f;
 	uint  u;
 	int   i;
@@ -56,6 +93,8 @@ union Data32
 	Data32(uint  u)   : u(u)  {}
 	Data32(int   i)   : i(i)  {}
 	Data32(const LaserSet* s) : set(s) {}
+	Data32(const CompiledText* t) : text(t) {}
+	Data32(const VectorFont* f) : font(f) {}
 	Data32(){}
 	~Data32(){}
 };
@@ -76,10 +115,33 @@ class LaserQueue : public Queue<Data32,256>
 	// pop only on core 1
 
 public:
-	void push (Data32 data)
+	// time spent waiting, for load balancing:
+	volatile uint32 core0_wait_us = 0;	// core0 waiting for free space => core1 is the bottleneck
+	volatile uint32 core1_wait_us = 0;	// core1 waiting for data => core0 is the bottleneck
+
+	void wait_free (uint n)		// core0
 	{
-		while (!free()) { gpio_put(LED_CORE0_IDLE,1); }
+		uint32 start = time_us_32();
+		gpio_put(LED_CORE0_IDLE,1);
+		while (free() < n) {}
 		gpio_put(LED_CORE0_IDLE,0);
+		uint32 wait_us = time_us_32() - start;
+		core0_wait_us += wait_us;
+		TRACE(TRACE_CORE0_WAIT, wait_us);
+	}
+
+	void wait_avail (uint n)	// core1
+	{
+		uint32 start = time_us_32();
+		while (avail() < n) {}		// __wfe()
+		uint32 wait_us = time_us_32() - start;
+		core1_wait_us += wait_us;
+		TRACE(TRACE_CORE1_WAIT, wait_us);
+	}
+
+	void push (Data32 data)
+	{
+		if (!free()) wait_free(1);
 		putc(data);
 	}
 
@@ -97,7 +159,7 @@ public:
 
 	Data32 pop ()
 	{
-		while (!avail()) {}		// __wfe()
+		if (!avail()) wait_avail(1);
 		return getc();
 	}
 
@@ -158,14 +220,16 @@ public:
 
 	static Transformation transformation0;			// transformation used by core0 (App)
 	static Transformation transformation1;			// transformation used by core1 (scanner backend)
+	static bool transform_on_core0;					// core0 sends transformed points, core1 uses identity
 	static Transformation transformation_stack[];	// push stack maintained by core0
 	static uint transformation_stack_index;
 
 	XY2(){}
 	static void init();
 	static void start();
-	static void suspend();
+	static void suspend();		// core1 stops between two commands with the laser off, e.g. for writing to Flash
 	static void resume();
+	static void waitIdle();		// wait until core1 has taken all commands, e.g. at the end of a frame
 
 	// core0: push to laser_queue:
 	static void moveTo (const Point& dest);
@@ -173,12 +237,35 @@ public:
 	static void drawLine (const Point& start, const Point& dest, const LaserSet&);
 	static void drawRect (const Rect& rect, const LaserSet&);
 	static void drawEllipse (const Rect& bbox, FLOAT angle0, uint steps, const LaserSet&);
+	static void drawArc (const Point& center, FLOAT radius_x, FLOAT radius_y, FLOAT angle0, FLOAT sweep, const LaserSet&);
+	static void drawCubic (const Point& p0, const Point& p1, const Point& p2, const Point& p3, const LaserSet&);
+	static void drawLissajous (uint count, FLOAT x_scale, FLOAT y_scale, FLOAT x_step,
+							   FLOAT f_ratio_center, FLOAT f_ratio_scale, FLOAT f_ratio_step, const LaserSet&);
 	static void drawPolyLine (uint count, std::function<Point()> nextPoint, const LaserSet&, PolyLineOptions=POLYLINE_DEFAULT);
 	static void drawPolyLine (uint count, const Point points[], const LaserSet&, PolyLineOptions=POLYLINE_DEFAULT);
 	static void drawPolygon (uint count, std::function<Point()> nextPoint, const LaserSet&);
 	static void drawPolygon (uint count, const Point points[], const LaserSet&);
 	static void printText (Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered = false,
-						   const LaserSet& = slow_straight, const LaserSet& = slow_rounded);
+						   const LaserSet& = slow_straight, const LaserSet& = slow_rounded, const VectorFont& = vt_font);
+	static void drawText (const CompiledText&);
+
+	// Curves: flattened by core1 into samples of max. LaserSet.speed distance, without corner dwell.
+	// drawArc(): points center + (radius_x*cos(a), radius_y*sin(a)) for a = angle0 … angle0+sweep.
+	//   a full ellipse has sweep = ±2pi. drawEllipse() in contrast draws a polygon with corners.
+	// drawCubic(): cubic Bézier curve from p0 to p3 with control points p1 and p2.
+	// curves are always transformed by core1, like text.
+	static constexpr uint CURVE_SEGMENTS = 16;	// segments for measuring the length of a curve
+
+	// Generators: core1 calculates the points, core0 only sends the parameters.
+	// drawLissajous(): count points of x = sin(ax) * x_scale, y = cos(ay) * y_scale,
+	//   with ax += x_step and ay += x_step * f_ratio per point, and f_ratio = center + sin(af) * scale with af += f_ratio_step.
+	//   the angles are kept by core1 and the figure continues seamlessly with the next call.
+	//   it is drawn like a POLYLINE_INFINITE and is always transformed by core1, like text.
+
+	// CompiledText: drawn by reference by core1.
+	// the CMD_DRAW_TEXT commands are counted so that core0 can wait until core1 is done with a text.
+	static uint32 texts_sent;			// core0
+	static volatile uint32 texts_done;	// core1
 
 	static void resetTransformation();
 	static void pushTransformation();
@@ -207,16 +294,97 @@ public:
 	static void transform (const Transformation& transformation);
 	static void transform (FLOAT fx, FLOAT fy, FLOAT sx, FLOAT sy, FLOAT dx, FLOAT dy);
 
+	// Scan time estimation:
+	// return the samples which core1 will need to draw a primitive with the given transformation,
+	// by default the current one, using the same maths as draw_to().
+	// pos is the scanner position after the previous primitive, the jump from there is included,
+	// and pos is updated for the next estimate. nothing is sent to core1.
+	static uint costMoveTo (Point& pos, const Point& dest, const Transformation& = transformation0);
+	static uint costLine (Point& pos, const Point& start, const Point& dest, const LaserSet&, const Transformation& = transformation0);
+	static uint costRect (Point& pos, const Rect& rect, const LaserSet&, const Transformation& = transformation0);
+	static uint costEllipse (Point& pos, const Rect& bbox, FLOAT angle0, uint steps, const LaserSet&, const Transformation& = transformation0);
+	static uint costArc (Point& pos, const Point& center, FLOAT radius_x, FLOAT radius_y, FLOAT angle0, FLOAT sweep, const LaserSet&, const Transformation& = transformation0);
+	static uint costCubic (Point& pos, const Point& p0, const Point& p1, const Point& p2, const Point& p3, const LaserSet&, const Transformation& = transformation0);
+	static uint costPolyLine (Point& pos, uint count, std::function<Point()> nextPoint, const LaserSet&, PolyLineOptions=POLYLINE_DEFAULT, const Transformation& = transformation0);
+	static uint costPolyLine (Point& pos, uint count, const Point points[], const LaserSet&, PolyLineOptions=POLYLINE_DEFAULT, const Transformation& = transformation0);
+	static uint costPolygon (Point& pos, uint count, std::function<Point()> nextPoint, const LaserSet&, const Transformation& = transformation0);
+	static uint costPolygon (Point& pos, uint count, const Point points[], const LaserSet&, const Transformation& = transformation0);
+	static uint costText (Point& pos, Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered = false,
+						  const LaserSet& = slow_straight, const LaserSet& = slow_rounded, const VectorFont& = vt_font,
+						  const Transformation& = transformation0);
+	static uint costText (Point& pos, const CompiledText&, const Transformation& = transformation0);
+
 	// Monitoring:
 	static uint16 getUnderruns();	// since last call
 
+	// Load balancing:
+	// select which core transforms the points.
+	// balanceLoad() should be called once per frame to select the core with less load.
+	static void setTransformOnCore0 (bool);
+	static void balanceLoad();
+
 
 private:
 	static void worker();		// on core1
 
 	static void update_transformation ();
+	static void send_transformation ();
+	static Point transformed (const Point& p) { return transform_on_core0 ? transformation0.transformed(p) : p; }
 	static uint delayed_laser_value (uint value);
 
+	struct Lissajous		// generator state of CMD_LISSAJOUS
+	{
+		// no float and no sin() per point:
+		// the y step x_step * f_ratio = x_step * f_ratio_center + y_mod * f_ratio.sin is the angle of the oscillator y_step,
+		// which is rotated by the change d of y_mod * f_ratio.sin in every point. d is small, so sin(d) and cos(d) are
+		// taken from their series. y_mod_angle is kept in an int64, so the changes add up exactly.
+		// y_step is set exactly in setSteps(), so the rounding errors don't accumulate across frames.
+
+		typedef Oscillator::Q30 Q30;
+
+		int32 x_scale = 0, y_scale = 0;		// scanner units
+		FLOAT x_step = 0, f_ratio_center = 1, f_ratio_scale = 0, f_ratio_step = 0;
+		Oscillator x, y, f_ratio, y_step;
+		TFixed<24> y_mod = 0;				// x_step * f_ratio_scale
+		int64 y_mod_angle = 0;				// y_mod * f_ratio.sin in Q30
+
+		void setScales (FLOAT xscale, FLOAT yscale)
+		{
+			x_scale = int32(xscale + (xscale < 0 ? -0.5f : 0.5f));
+			y_scale = int32(yscale + (yscale < 0 ? -0.5f : 0.5f));
+		}
+
+		void setSteps (FLOAT xstep, FLOAT fstep)
+		{
+			if (xstep != x_step) { x_step = xstep; x.setStep(xstep); }
+			if (fstep != f_ratio_step) { f_ratio_step = fstep; f_ratio.setStep(fstep); }
+
+			y_mod = x_step * f_ratio_scale;
+			y_mod_angle = mod_angle();
+			y_step.setAngle(x_step * (f_ratio_center + FLOAT(f_ratio.sin) * f_ratio_scale));
+		}
+
+		int64 mod_angle () const { return (int64(f_ratio.sin.raw) * y_mod.raw + (1<<23)) >> 24; }
+
+		static int32 scaled (Q30 a, int32 scale) { return int32((int64(a.raw) * scale + (1<<29)) >> 30); }
+
+		Point next ()
+		{
+			f_ratio.next();
+			const int64 a = mod_angle();
+			const Q30 d = Q30::fromRaw(int32(a - y_mod_angle));
+			y_mod_angle = a;
+			const Q30 d2 = d * d;
+			y_step.next(d - d * d2 * Q30(1.0/6), Q30(1) - d2 * Q30(0.5));
+
+			x.next();
+			y.next(y_step.sin, y_step.cos);
+
+			return Point(FLOAT(scaled(x.sin, x_scale)), FLOAT(scaled(y.cos, y_scale)));
+		}
+	};
+	static Lissajous lissajous;
+
 	static uint pio_avail() { return pio_sm_get_tx_fifo_level(pio,sm_x); }
 	static uint pio_free() { return 8 - pio_sm_get_tx_fifo_level(pio,sm_x);}
 
@@ -270,13 +438,35 @@ private:
 		pio_send_data(p.x,p.y,laser);
 	}
 
+	static uint cost_to (Point& pos, const Point& dest, FLOAT speed, uint end_delay);
+	static uint cost_polyline (Point& pos, uint count, std::function<Point()> nextPoint, const LaserSet&, uint options);
+	static uint cost_char (Point& pos, Point& textpos, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded,
+						   const VectorFont&, char& prev, char c, const Transformation&);
+
 	static void draw_to (Point dest, FLOAT speed, uint laser_on_pattern, uint& laser_on_delay, uint end_delay);
+	template<typename CURVE> static void draw_curve (CURVE curve, const LaserSet&);
+	template<typename CURVE> static uint cost_curve (Point& pos, CURVE curve, const LaserSet&, const Transformation&);
+
+	static Point arc_point (const Point& center, FLOAT rx, FLOAT ry, FLOAT angle0, FLOAT sweep, FLOAT t)
+	{
+		FLOAT sin, cos;
+		fast_sincos(angle0 + sweep * t, sin, cos);
+		return Point(center.x + rx * cos, center.y + ry * sin);
+	}
+	static Point cubic_point (const Point& p0, const Point& p1, const Point& p2, const Point& p3, FLOAT t)
+	{
+		FLOAT u = 1 - t;
+		FLOAT a = u*u*u, b = 3*u*u*t, c = 3*u*t*t, d = t*t*t;
+		return Point(a*p0.x + b*p1.x + c*p2.x + d*p3.x, a*p0.y + b*p1.y + c*p2.y + d*p3.y);
+	}
 	static void move_to (const Point& dest) { line_to(dest,laser_set[0]); }
 	static void line_to (const Point& dest, const LaserSet&);
 	static void draw_line (const Point& start, const Point& dest, const LaserSet&);
 	static void draw_rect (const Rect& rect, const LaserSet&);
 	static void draw_polyline (uint count, std::function<Point()> readNextPoint, const LaserSet&, uint options);
-	static void print_char (Point& textpos, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded, uint8& rmask, char c);
+	static void draw_text (const Data32* strokes);
+	static void print_char (Point& textpos, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded,
+							const VectorFont&, char& prev, char c);
 };
 
 
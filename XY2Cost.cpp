@@ -0,0 +1,203 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include <math.h>
+#include "cdefs.h"
+#include "fast_trig.h"
+#include "XY2.h"
+#include "VectorFont.h"
+#include "CompiledText.h"
+
+
+// Scan time estimation
+// these functions follow the drawing functions of core1 step by step
+// but only count the samples which would be sent to the scanner.
+// they don't access the laser_queue or the pio and can be used on core0.
+
+static const FLOAT pi = FLOAT(3.1415926538);
+
+
+uint XY2::cost_to (Point& pos, const Point& dest, FLOAT speed, uint end_delay)
+{
+	// same as draw_to():
+	// steps of size speed, a last step to dest if pos != dest, then the end delay
+
+	FLOAT line_length = (dest - pos).length();
+	pos = dest;
+	return (line_length > 0 ? uint(ceil(line_length / speed)) : 0) + end_delay;
+}
+
+uint XY2::costMoveTo (Point& pos, const Point& dest, const Transformation& t)
+{
+	const LaserSet& set = laser_set[0];
+	return cost_to(pos, t.transformed(dest), set.speed, set.delay_e);
+}
+
+uint XY2::costLine (Point& pos, const Point& start, const Point& dest, const LaserSet& set, const Transformation& t)
+{
+	uint cost = costMoveTo(pos, start, t);
+	return cost + cost_to(pos, t.transformed(dest), set.speed, set.delay_e);
+}
+
+uint XY2::costRect (Point& pos, const Rect& rect, const LaserSet& set, const Transformation& t)
+{
+	uint cost = costMoveTo(pos, rect.top_left(), t);
+	cost += cost_to(pos, t.transformed(rect.top_right()), set.speed, set.delay_e);
+	cost += cost_to(pos, t.transformed(rect.bottom_right()), set.speed, set.delay_e);
+	cost += cost_to(pos, t.transformed(rect.bottom_left()), set.speed, set.delay_e);
+	cost += cost_to(pos, t.transformed(rect.top_left()), set.speed, set.delay_e);
+	return cost;
+}
+
+uint XY2::costEllipse (Point& pos, const Rect& bbox, FLOAT angle, uint steps, const LaserSet& set, const Transformation& t)
+{
+	// same points as drawEllipse()
+
+	Point center = bbox.center();
+	FLOAT fx = bbox.width()/2;
+	FLOAT fy = bbox.height()/2;
+
+	SinCosStepper a(angle, 2*pi / FLOAT(steps));
+
+	return costPolyLine(pos, steps, [center,fx,fy,&a]()
+	{
+		Point p = center + Dist(fx*a.cos,fy*a.sin);
+		a.next();
+		return p;
+	},
+	set, POLYLINE_CLOSED, t);
+}
+
+uint XY2::costArc (Point& pos, const Point& center, FLOAT rx, FLOAT ry, FLOAT angle0, FLOAT sweep, const LaserSet& set, const Transformation& t)
+{
+	return cost_curve(pos, [=](FLOAT u){ return arc_point(center,rx,ry,angle0,sweep,u); }, set, t);
+}
+
+uint XY2::costCubic (Point& pos, const Point& p0, const Point& p1, const Point& p2, const Point& p3, const LaserSet& set, const Transformation& t)
+{
+	return cost_curve(pos, [=](FLOAT u){ return cubic_point(p0,p1,p2,p3,u); }, set, t);
+}
+
+template<typename CURVE>
+uint XY2::cost_curve (Point& pos, CURVE curve, const LaserSet& set, const Transformation& t)
+{
+	// same as draw_curve()
+
+	uint cost = costMoveTo(pos, curve(0), t);
+
+	FLOAT length = 0;
+	for (uint k=1; k<=CURVE_SEGMENTS; k++)
+	{
+		Point p1 = t.transformed(curve(FLOAT(k) / CURVE_SEGMENTS));
+		length += (p1 - pos).length();
+		pos = p1;
+	}
+
+	return cost + uint(ceil(length / set.speed)) + set.delay_e;
+}
+
+uint XY2::cost_polyline (Point& pos, uint count, std::function<Point()> next_point, const LaserSet& set, uint flags)
+{
+	// same as draw_polyline()
+	// next_point() returns transformed points
+
+	bool closed   = flags == POLYLINE_CLOSED;
+	bool no_start = flags & POLYLINE_NO_START;
+	bool no_end   = flags & POLYLINE_NO_END;
+
+	uint cost = 0;
+	Point start;
+	if (!no_start && count--) { start = next_point(); cost += cost_to(pos, start, laser_set[0].speed, laser_set[0].delay_e); }
+	if (count == 0) return cost;
+
+	uint delay = set.delay_m;
+	while (count--)
+	{
+		if (count==0 && !no_end) delay = set.delay_e;
+		cost += cost_to(pos, next_point(), set.speed, delay);
+	}
+
+	if (closed) cost += cost_to(pos, start, set.speed, set.delay_e);
+	return cost;
+}
+
+uint XY2::costPolyLine (Point& pos, uint count, std::function<Point()> nextPoint, const LaserSet& set, PolyLineOptions flags, const Transformation& t)
+{
+	return cost_polyline(pos, count, [&nextPoint,&t](){ return t.transformed(nextPoint()); }, set, flags);
+}
+
+uint XY2::costPolyLine (Point& pos, uint count, const Point points[], const LaserSet& set, PolyLineOptions flags, const Transformation& t)
+{
+	return cost_polyline(pos, count, [&points,&t](){ return t.transformed(*points++); }, set, flags);
+}
+
+uint XY2::costPolygon (Point& pos, uint count, std::function<Point()> nextPoint, const LaserSet& set, const Transformation& t)
+{
+	return costPolyLine(pos, count, nextPoint, set, POLYLINE_CLOSED, t);
+}
+
+uint XY2::costPolygon (Point& pos, uint count, const Point points[], const LaserSet& set, const Transformation& t)
+{
+	return costPolyLine(pos, count, points, set, POLYLINE_CLOSED, t);
+}
+
+uint XY2::cost_char (Point& pos, Point& p0, FLOAT scale_x, FLOAT scale_y, const LaserSet& straight, const LaserSet& rounded,
+					 const VectorFont& font, char& prev, char c, const Transformation& t)
+{
+	// same as print_char()
+
+	const VtGlyph& glyph = font.glyph(c);
+	const int8* p = font.strokes(glyph);
+
+	p0.x += font.kerning(prev,c) * scale_x;		// apply kerning
+	prev = c;									// for next kerning
+
+	uint cost = 0;
+	while (*p != VT_END)
+	{
+		const LaserSet& set = *p++ == VT_STRAIGHT ? straight : rounded;
+
+		Point pt;
+		pt.x = p0.x + *p++ * scale_x;
+		pt.y = p0.y + *p++ * scale_y;
+		cost += costMoveTo(pos, pt, t);
+
+		while (*p < VT_END)
+		{
+			pt.x = p0.x + *p++ * scale_x;
+			pt.y = p0.y + *p++ * scale_y;
+			cost += cost_to(pos, t.transformed(pt), set.speed, *p<VT_END ? set.delay_m : set.delay_e);
+		}
+	}
+
+	p0.x += glyph.width * scale_x;	// update print position
+	return cost;
+}
+
+uint XY2::costText (Point& pos, Point start, FLOAT scale_x, FLOAT scale_y, cstr text, bool centered,
+					const LaserSet& straight, const LaserSet& rounded, const VectorFont& font, const Transformation& t)
+{
+	if (centered) start.x -= font.printWidth(text) * scale_x / 2;
+
+	uint cost = 0;
+	char prev = 0;
+	while (char c = *text++) { cost += cost_char(pos, start, scale_x, scale_y, straight, rounded, font, prev, c, t); }
+	return cost;
+}
+
+uint XY2::costText (Point& pos, const CompiledText& text, const Transformation& t)
+{
+	// same as draw_text()
+
+	uint cost = 0;
+	const Data32* p = text.getStrokes();
+	while (const LaserSet* set = p++->set)
+	{
+		uint count = p++->u;
+		cost += cost_polyline(pos, count, [&p,&t](){ Point pt(p[0].f,p[1].f); p += 2; return t.transformed(pt); }, *set, POLYLINE_DEFAULT);
+	}
+	return cost;
+}
@@ -6,6 +6,8 @@
 
 #include "demos.h"
 #include "cdefs.h"
+#include "fast_trig.h"
+#include "Wireframe.h"
 #include <math.h>
 
 //static inline FLOAT sin (FLOAT a) { return sinf(a); }
@@ -51,7 +53,6 @@ void drawClock (const Rect& bbox, uint32 second_of_day, const LaserSet& straight
 	FLOAT hour   = FLOAT(second_of_day % (60*60*12)) / (60*60);
 
 	uint i;
-	FLOAT rad;
 	Point triangle[3];
 	const FLOAT radius = bbox.width()/2;
 
@@ -65,13 +66,13 @@ void drawClock (const Rect& bbox, uint32 second_of_day, const LaserSet& straight
 		HH_LENGTH  = FLOAT(0.55), HH_I_DIA = FLOAT(-0.15), HH_WIDTH = FLOAT(0.05); // hour handle
 
 	// draw outer ring:
-	XY2::drawEllipse(bbox * O_RING_DIA, pi/2, 12*2, rounded);   // start at 12 o'clock
+	XY2::drawArc(Point(0,0), radius * O_RING_DIA, radius * O_RING_DIA, pi/2, 2*pi, rounded);   // start at 12 o'clock
 
 	// draw full hour markers for 1 to 11 o'clock:
-	for (i=1; i<=11; i++)
+	SinCosStepper a(pi*2 / 12, pi*2 / 12);
+	for (i=1; i<=11; i++, a.next())
 	{
-		rad = pi*2 / 12 * FLOAT(i);
-		Point direction { radius * sin(rad), radius * cos(rad) };
+		Point direction { radius * a.sin, radius * a.cos };
 		XY2::drawLine(direction * HM_O_DIA, direction * HM_I_DIA, straight);
 	}
 
@@ -85,8 +86,9 @@ void drawClock (const Rect& bbox, uint32 second_of_day, const LaserSet& straight
 	// draw the handles starting and ending at the clock center to minimize jumps:
 
 	// draw second handle:
-	rad = pi*2 / 60 * second;
-	Point direction { radius * sin(rad), radius * cos(rad) };
+	FLOAT sinus, cosin;
+	fast_sincos(pi*2 / 60 * second, sinus, cosin);
+	Point direction { radius * sinus, radius * cosin };
 	//XY2::drawLine(direction * SH_I_DIA,  direction * SH_LENGTH, straight);
 	XY2::drawLine(direction * SH_LENGTH, direction * SH_I_DIA, straight);
 
@@ -95,9 +97,9 @@ void drawClock (const Rect& bbox, uint32 second_of_day, const LaserSet& straight
 	triangle[1] = Point(-MH_WIDTH, MH_I_DIA);
 	triangle[2] = Point(+MH_WIDTH, MH_I_DIA);
 
-	rad = pi*2 / 60 * minute;
-	FLOAT sinus = sin(rad) * radius;
-	FLOAT cosin = cos(rad) * radius;
+	fast_sincos(pi*2 / 60 * minute, sinus, cosin);
+	sinus *= radius;
+	cosin *= radius;
 	for (i=0; i<3; i++) { triangle[i].rotate_cw(sinus,cosin); }
 	XY2::drawPolygon(3,triangle, straight);		// start drawing at base
 
@@ -106,41 +108,24 @@ void drawClock (const Rect& bbox, uint32 second_of_day, const LaserSet& straight
 	triangle[1] = Point(-HH_WIDTH, HH_I_DIA);
 	triangle[2] = Point(+HH_WIDTH, HH_I_DIA);
 
-	rad = pi*2 / 12 * hour;
-	sinus = sin(rad) * radius;
-	cosin = cos(rad) * radius;
+	fast_sincos(pi*2 / 12 * hour, sinus, cosin);
+	sinus *= radius;
+	cosin *= radius;
 	for (i=0; i<3; i++) { triangle[i].rotate_cw(sinus,cosin); }
 	XY2::drawPolygon(3, triangle, straight);	// start drawing at base
 
 	// draw inner ring: (axis)
-	XY2::drawEllipse(bbox * I_RING_DIA, FLOAT(0.0), 8, rounded);
+	XY2::drawArc(Point(0,0), radius * I_RING_DIA, radius * I_RING_DIA, FLOAT(0.0), 2*pi, rounded);
 }
 #endif
 
 
 #ifdef XY2_IMPLEMENT_LISSAJOUS_DEMO
-void drawLissajous (FLOAT width, FLOAT height, LissajousData& p, const LaserSet& set)
+void drawLissajous (FLOAT width, FLOAT height, const LissajousData& p, const LaserSet& set)
 {
-	p.x_scale = width / 2;
-	p.y_scale = height / 2;
+	// the points are calculated by core1 which continues where the previous frame ended:
 
-	XY2::drawPolyLine(2500, [&p]()
-	{
-		p.f_ratio_angle += p.f_ratio_angle_step;
-		if (p.f_ratio_angle >= pi) p.f_ratio_angle -= pi*2;
-		FLOAT f_ratio = p.f_ratio_center + sin(p.f_ratio_angle) * p.f_ratio_scale;
-
-		p.x_angle += p.x_step;
-		if (p.x_angle >= pi) p.x_angle -= pi*2;
-		p.y_angle += p.x_step * f_ratio;
-		if (p.y_angle >= pi) p.y_angle -= pi*2;
-
-		FLOAT x = sin(p.x_angle) * p.x_scale;
-		FLOAT y = cos(p.y_angle) * p.y_scale;
-
-		return Point{x,y};
-	},
-	set, POLYLINE_INFINITE);
+	XY2::drawLissajous(2500, width/2, height/2, p.x_step, p.f_ratio_center, p.f_ratio_scale, p.f_ratio_angle_step, set);
 }
 
 LissajousData::LissajousData (FLOAT min_f_ratio, FLOAT max_f_ratio, FLOAT steps_per_rot, FLOAT rots_per_sweep)
@@ -150,15 +135,48 @@ LissajousData::LissajousData (FLOAT min_f_ratio, FLOAT max_f_ratio, FLOAT steps_
 	min_f_ratio = minmax(FLOAT(0.5), min_f_ratio, FLOAT(10.05));	// min. fy/fx ratio
 	max_f_ratio = minmax(min_f_ratio, max_f_ratio, FLOAT(10.05));	// max. fy/fx ratio
 
-	x_scale = 100;
-	y_scale = 100;
 	x_step  = 2*pi / steps_per_rot;
-	x_angle = 0;
-	y_angle = 0;
 	f_ratio_center = sqrt(min_f_ratio * max_f_ratio);
 	f_ratio_angle_step = 2*pi / steps_per_rot / rots_per_sweep;
-	f_ratio_angle = 0;
 	f_ratio_scale = (max_f_ratio-min_f_ratio)/2;
 }
 #endif
 
+
+
+#ifdef XY2_IMPLEMENT_WIREFRAME_DEMO
+void drawWireframe (FLOAT width, FLOAT rad, const LaserSet& set)
+{
+	// rotating icosahedron:
+	// the faces are all triangles of vertices with distance 2, each edge is added by 2 faces.
+
+	static Mesh* mesh = nullptr;
+	if (!mesh)
+	{
+		const FLOAT g = FLOAT(1.6180339887);	// golden ratio
+		const Point3 v[12] =
+		{
+			{0,-1,-g}, {0,-1,+g}, {0,+1,-g}, {0,+1,+g},
+			{-1,-g,0}, {-1,+g,0}, {+1,-g,0}, {+1,+g,0},
+			{-g,0,-1}, {+g,0,-1}, {-g,0,+1}, {+g,0,+1},
+		};
+		mesh = new Mesh(12, v);
+
+		auto edge = [&v](uint i, uint j) { return abs((v[i] - v[j]).length() - 2) < FLOAT(0.01); };
+		for (uint16 i=0; i<12; i++)
+		for (uint16 j=i+1; j<12; j++)
+		for (uint16 k=j+1; k<12; k++)
+		{
+			uint16 face[3] = {i,j,k};
+			if (edge(i,j) && edge(j,k) && edge(k,i)) mesh->addPolygon(3,face);
+		}
+	}
+
+	// the icosahedron has a radius of 1.9 => distance for the requested width:
+	Camera camera;
+	camera.position = Point3(0, 0, -4);
+	camera.focal_length = width / 2 / FLOAT(1.9) * 4;
+
+	mesh->draw(camera, Matrix4::rotationY(rad) * Matrix4::rotationX(fast_sin(rad) * FLOAT(0.4)), set);
+}
+#endif
@@ -12,12 +12,13 @@
 //#ifdef XY2_IMPLEMENT_CHECKER_BOARD_DEMO
 //#ifdef XY2_IMPLEMENT_ANALOGUE_CLOCK_DEMO
 //#ifdef XY2_IMPLEMENT_LISSAJOUS_DEMO
+//#ifdef XY2_IMPLEMENT_WIREFRAME_DEMO
 
 
-struct LissajousData
+struct LissajousData		// parameters only: the angles are kept by core1
 {
-	FLOAT x_scale, y_scale, x_step, x_angle, y_angle;
-	FLOAT f_ratio_center, f_ratio_angle_step, f_ratio_angle, f_ratio_scale;
+	FLOAT x_step;
+	FLOAT f_ratio_center, f_ratio_angle_step, f_ratio_scale;
 
 	LissajousData(FLOAT min_f_ratio, FLOAT max_f_ratio, FLOAT steps_per_rot, FLOAT rots_per_sweep);
 };
@@ -26,4 +27,5 @@ struct LissajousData
 // run on core0:
 extern void drawCheckerBoard (const Rect& bbox, uint count, const LaserSet&);
 extern void drawClock (const Rect& bbox, uint32 second, const LaserSet& straight, const LaserSet& rounded);
-extern void drawLissajous (FLOAT width, FLOAT height, LissajousData&, const LaserSet&);
+extern void drawLissajous (FLOAT width, FLOAT height, const LissajousData&, const LaserSet&);
+extern void drawWireframe (FLOAT width, FLOAT rad, const LaserSet&);
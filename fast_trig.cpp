@@ -0,0 +1,37 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#include "fast_trig.h"
+
+
+// ====================================================================
+//		calculate the sine table at compile time
+// ====================================================================
+
+static constexpr double taylor_sin (double x)
+{
+	// Taylor series for 0 ≤ x ≤ pi/2: the last term is < 1e-20
+
+	double term = x, sum = x;
+	for (int n = 3; n < 30; n += 2)
+	{
+		term = -term * x * x / (n * (n-1));
+		sum += term;
+	}
+	return sum;
+}
+
+static constexpr SinTable make_sin_table ()
+{
+	SinTable table {};
+	for (uint i = 0; i <= SIN_TABLE_SIZE; i++)
+	{
+		table.v[i] = FLOAT(taylor_sin(i * (3.14159265358979323846 / 2) / SIN_TABLE_SIZE));
+	}
+	return table;
+}
+
+constexpr SinTable sin_table = make_sin_table();
@@ -0,0 +1,104 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include <cmath>
+#include "cdefs.h"
+
+
+// Fast sin() and cos() from a quarter wave table with linear interpolation.
+//
+// sin() and cos() are software double functions on the RP2040 and there are a lot of them per frame:
+// every rotate() of a Transformation, every point of an ellipse etc.
+// the table has 257 FLOATs in flash and is calculated by the compiler.
+//
+// error: |fast_sin(a) - sin(a)| < 5e-6 for |a| ≤ 2pi, which is far below 1 scanner unit for any radius.
+// for larger angles the resolution of a FLOAT adds to this: < 1e-5 for |a| < 100.
+// the angle is converted to an int32 table index: |a| must be < 1e6.
+//
+// SinCosStepper: sin and cos for evenly spaced angles start + n * step, e.g. for the points of an ellipse.
+// it rotates the previous (sin,cos) by the step: 4 multiplications per point.
+// the step is calculated once with the precise sinf() and cosf() because its error would accumulate.
+// the error grows only slowly with n: after 1000 steps it is still < 1e-5.
+
+static constexpr uint SIN_TABLE_SIZE = 256;		// entries per quarter wave, plus 1
+
+struct SinTable { FLOAT v[SIN_TABLE_SIZE+1]; };
+extern const SinTable sin_table;				// sin(0) … sin(pi/2)
+
+
+inline FLOAT sin_from_table (uint i, FLOAT f)
+{
+	// i = index in the full wave of 4*SIN_TABLE_SIZE steps, any value: it wraps around
+	// f = fraction 0 … 1 to the next index
+
+	const uint j = i % SIN_TABLE_SIZE;
+	const uint q = i / SIN_TABLE_SIZE;
+	const FLOAT* v = sin_table.v;
+
+	FLOAT a, b;
+	if (q & 1) { a = v[SIN_TABLE_SIZE-j]; b = v[SIN_TABLE_SIZE-j-1]; }		// falling quarter
+	else       { a = v[j]; b = v[j+1]; }										// rising quarter
+	a += (b-a) * f;
+	return q & 2 ? -a : a;														// negative half wave
+}
+
+inline void fast_sincos (FLOAT rad, FLOAT& sin, FLOAT& cos)
+{
+	constexpr FLOAT steps_per_rad = FLOAT(SIN_TABLE_SIZE * 2 / 3.14159265358979323846);
+
+	const FLOAT t = rad * steps_per_rad;
+	int32 i = int32(t);
+	if (t < FLOAT(i)) i--;					// round down for negative angles
+	const FLOAT f = t - FLOAT(i);
+
+	sin = sin_from_table(uint(i), f);
+	cos = sin_from_table(uint(i) + SIN_TABLE_SIZE, f);
+}
+
+inline FLOAT fast_sin (FLOAT rad)
+{
+	constexpr FLOAT steps_per_rad = FLOAT(SIN_TABLE_SIZE * 2 / 3.14159265358979323846);
+
+	const FLOAT t = rad * steps_per_rad;
+	int32 i = int32(t);
+	if (t < FLOAT(i)) i--;
+	return sin_from_table(uint(i), t - FLOAT(i));
+}
+
+inline FLOAT fast_cos (FLOAT rad)
+{
+	constexpr FLOAT steps_per_rad = FLOAT(SIN_TABLE_SIZE * 2 / 3.14159265358979323846);
+
+	const FLOAT t = rad * steps_per_rad;
+	int32 i = int32(t);
+	if (t < FLOAT(i)) i--;
+	return sin_from_table(uint(i) + SIN_TABLE_SIZE, t - FLOAT(i));
+}
+
+
+class SinCosStepper
+{
+public:
+	FLOAT sin, cos;			// for the current angle
+
+	SinCosStepper (FLOAT start, FLOAT step)
+	{
+		fast_sincos(start, sin, cos);
+		step_sin = std::sin(step);
+		step_cos = std::cos(step);
+	}
+
+	void next ()			// advance to the next angle
+	{
+		const FLOAT s = sin;
+		sin = s * step_cos + cos * step_sin;
+		cos = cos * step_cos - s * step_sin;
+	}
+
+private:
+	FLOAT step_sin, step_cos;
+};
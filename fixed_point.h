@@ -0,0 +1,153 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+
+#include <cmath>
+#include "cdefs.h"
+#include "fast_trig.h"
+
+
+/*
+ * Template for a signed fixed point number with FRAC fractional bits in an int32.
+ *
+ * This is a drop-in number type for TDist, TPoint and TTransformation
+ * for code which should not use the software float library of the RP2040.
+ * Multiplication and division use 64 bit intermediates.
+ * The results are rounded but not saturated: overflow wraps around like int32.
+ *
+ * Fixed = TFixed<16> = Q16.16:  range ±32768 with a resolution of 1/65536.
+ * note: the scanner range is ±0x8000 too, so a point just on the edge of the scanner range overflows.
+ */
+template<int FRAC>
+struct TFixed
+{
+	static constexpr int32 ONE = int32(1) << FRAC;
+
+	int32 raw = 0;
+
+	TFixed() = default;
+	constexpr TFixed (int n) : raw(n * ONE) {}
+	constexpr TFixed (float f) : raw(int32(f * ONE + (f < 0 ? -0.5f : 0.5f))) {}
+	constexpr TFixed (double f) : raw(int32(f * ONE + (f < 0 ? -0.5 : 0.5))) {}
+
+	static constexpr TFixed fromRaw (int32 raw) { TFixed z; z.raw = raw; return z; }
+
+	explicit constexpr operator float () const	{ return float(raw) * (1.0f / ONE); }
+	explicit constexpr operator double () const	{ return double(raw) * (1.0 / ONE); }
+	explicit constexpr operator int () const	{ return raw >> FRAC; }		// rounded down
+	explicit constexpr operator bool () const	{ return raw != 0; }
+
+	int round () const { return (raw + ONE/2) >> FRAC; }
+
+	constexpr TFixed operator- () const { return fromRaw(-raw); }
+	constexpr TFixed operator+ () const { return *this; }
+
+	friend constexpr TFixed operator+ (TFixed a, TFixed b) { return fromRaw(a.raw + b.raw); }
+	friend constexpr TFixed operator- (TFixed a, TFixed b) { return fromRaw(a.raw - b.raw); }
+	friend constexpr TFixed operator* (TFixed a, TFixed b)
+	{
+		return fromRaw(int32((int64(a.raw) * b.raw + ONE/2) >> FRAC));
+	}
+	friend constexpr TFixed operator/ (TFixed a, TFixed b)
+	{
+		// rounded to nearest: add half of the divisor with the sign of the result
+		int64 n = int64(a.raw) * ONE;
+		int64 h = (b.raw < 0 ? -int64(b.raw) : int64(b.raw)) / 2;
+		return fromRaw(int32(((n < 0) == (b.raw < 0) ? n + h : n - h) / b.raw));
+	}
+
+	TFixed& operator+= (TFixed b) { return *this = *this + b; }
+	TFixed& operator-= (TFixed b) { return *this = *this - b; }
+	TFixed& operator*= (TFixed b) { return *this = *this * b; }
+	TFixed& operator/= (TFixed b) { return *this = *this / b; }
+
+	friend constexpr bool operator== (TFixed a, TFixed b) { return a.raw == b.raw; }
+	friend constexpr bool operator!= (TFixed a, TFixed b) { return a.raw != b.raw; }
+	friend constexpr bool operator<  (TFixed a, TFixed b) { return a.raw <  b.raw; }
+	friend constexpr bool operator<= (TFixed a, TFixed b) { return a.raw <= b.raw; }
+	friend constexpr bool operator>  (TFixed a, TFixed b) { return a.raw >  b.raw; }
+	friend constexpr bool operator>= (TFixed a, TFixed b) { return a.raw >= b.raw; }
+
+	// math functions found by ADL from the templates in basic_geometry.h:
+
+	friend TFixed abs (TFixed a) { return a.raw < 0 ? -a : a; }
+	friend TFixed sqrt (TFixed a) { return fromRaw(int32(isqrt(uint64(a.raw) << FRAC))); }	// a ≥ 0
+	friend TFixed sin (TFixed a) { return TFixed(fast_sin(FLOAT(a))); }
+	friend TFixed cos (TFixed a) { return TFixed(fast_cos(FLOAT(a))); }
+	friend void fast_sincos (TFixed a, TFixed& sin, TFixed& cos)
+	{
+		FLOAT s, c;
+		::fast_sincos(FLOAT(a), s, c);
+		sin = s; cos = c;
+	}
+	friend TFixed atan (TFixed a) { return TFixed(atanf(float(a))); }
+
+	static uint32 isqrt (uint64 n)
+	{
+		// integer square root, rounded down
+
+		uint64 root = 0;
+		uint64 bit  = uint64(1) << 62;
+		while (bit > n) bit >>= 2;
+
+		while (bit)
+		{
+			if (n >= root + bit) { n -= root + bit; root = (root >> 1) + bit; }
+			else root >>= 1;
+			bit >>= 2;
+		}
+		return uint32(root);
+	}
+};
+
+
+typedef TFixed<16> Fixed;
+
+
+/*
+ * Sine oscillator in Q2.30 fixed point:
+ * sin and cos of an angle which advances by a step with every next().
+ * the vector (cos,sin) is rotated with a rotation matrix: 4 multiplications and no sin() per step.
+ * the amplitude is renormalized in every step, so the rounding errors don't accumulate
+ * and it can run forever, e.g. on core1 across frames.
+ */
+class Oscillator
+{
+public:
+	typedef TFixed<30> Q30;
+
+	Q30 sin = 0, cos = 1;		// for the current angle, which starts at 0
+
+	void setStep (FLOAT step)
+	{
+		step_sin = Q30(std::sin(double(step)));
+		step_cos = Q30(std::cos(double(step)));
+	}
+
+	void setAngle (FLOAT angle)
+	{
+		sin = Q30(std::sin(double(angle)));
+		cos = Q30(std::cos(double(angle)));
+	}
+
+	void next () { next(step_sin,step_cos); }
+
+	void next (Q30 step_sin, Q30 step_cos)		// advance by a different step
+	{
+		const Q30 s = sin;
+		sin = s * step_cos + cos * step_sin;
+		cos = cos * step_cos - s * step_sin;
+
+		// renormalize: 1/sqrt(x) ≈ (3-x)/2 for x ≈ 1
+		const Q30 k = Q30(1.5) - (sin * sin + cos * cos) * Q30(0.5);
+		sin *= k;
+		cos *= k;
+	}
+
+private:
+	Q30 step_sin = 0, step_cos = 1;
+};
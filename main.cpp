@@ -23,11 +23,16 @@
 #include "FlashDrive.h"
 #include "HiScore.h"
 #include "DS3231.h"
+#include "Recorder.h"
+#include "Trace.h"
+#include "CompiledText.h"
+#include "MathBenchmark.h"
 
 
 static constexpr int ESC = 27;
 static constexpr FLOAT pi = FLOAT(3.1415926538);
 static HiScores hiscores;
+static bool hiscores_unsaved = false;	// writeFlashData() returned OUT_OF_SPACE: retry after the garbage collection
 static DS3231 rtc;
 static datetime_t t = {2000,1,1,1,12,0,0};
 
@@ -179,6 +184,7 @@ int main()
 		CHECKERBOARD_DEMO,
 		CLOCK_DEMO,
 		LISSAJOUS_DEMO,
+		WIREFRAME_DEMO,
 		LASEROIDS_GAME,
 		LASEROIDS_NEW_HIGHSCORE,	// big message
 		LASEROIDS_ENTER_HISCORE,
@@ -195,6 +201,18 @@ int main()
 	HiScore hiscore;	// hiscore input
 	int idx = 0;		// hiscore input
 
+	// static texts are compiled only once:
+	const CompiledText title(Point(0,0),w/25,h/20,"LASEROIDS!",true,fast_straight,fast_rounded);
+	const CompiledText subtitle(Point(0,-h/8),w/100,h/80,"on your Laser Scanner!",true,fast_straight,fast_rounded);
+	const CompiledText main_menu[] =
+	{
+		{Point(-30,+20),1,1,"1 Start",false,fast_straight,fast_rounded},
+		{Point(-30,+10),1,1,"2 HiScores",false,fast_straight,fast_rounded},
+		{Point(-30, 0),1,1,"3 Options",false,fast_straight,fast_rounded},
+		{Point(-30,-10),1,1,"4-6,0 Demos",false,fast_straight,fast_rounded},
+		{Point(-30,-20),1,1,"9 Stats",false,fast_straight,fast_rounded},
+	};
+
 	while (1)
 	{
 		uint32 now_us = time_us_32();
@@ -204,6 +222,9 @@ int main()
 		// switch off underrun indicator:
 		gpio_put(LED_PIN, 0);
 
+		// select core for transformations:
+		xy2.balanceLoad();
+
 		// display load stats:
 		if ((now_us - adc_last_time_us) >= 1000*1000)
 		{
@@ -246,6 +267,28 @@ int main()
 		}
 
 
+		// compact the FlashData in steps while no game is running.
+		// a step which only copies a record stops core1 for a few ms.
+		// a step which erases a sector stops it for ~45 ms, up to 400 ms: this is done at the frame boundary,
+		// after core1 has drawn the previous frame, and the laser is off until the next frame:
+		if ((state == MAIN_MENU || state == LASEROIDS_ANIMATION) && Flash::gcPending())
+		{
+			if (Flash::gcStepErases()) xy2.waitIdle();
+			xy2.suspend();
+			uint err = Flash::gcStep();
+			xy2.resume();
+			if (err) printf("flash garbage collection failed: %u\n", err);
+		}
+		else if ((state == MAIN_MENU || state == LASEROIDS_ANIMATION) && hiscores_unsaved)
+		{
+			hiscores_unsaved = false;
+			xy2.suspend();
+			uint err = Flash::writeFlashData(&hiscores);
+			xy2.resume();
+			if (err) printf("writing hiscores to flash failed: %u\n", err);
+			else printf("hiscore written to flash\n");
+		}
+
 		switch(state)
 		{
 		case BOOT_GEOMETRY_TEST:
@@ -267,9 +310,8 @@ int main()
 		case LASEROIDS_ANIMATION:
 		{
 			xy2.setRotation(-rad); rad += pi/180; if (rad>=2*pi) rad -= 2*pi;
-			//xy2.printText(Point(0,0),w/25,h/20,"LASEROIDS!",true);
-			xy2.printText(Point(0,0),w/25,h/20,"LASEROIDS!",true,fast_straight,fast_rounded);
-			xy2.printText(Point(0,-h/8),w/100,h/80,"on your Laser Scanner!",true,fast_straight,fast_rounded);
+			title.draw();
+			subtitle.draw();
 
 			if (getchar_timeout_us(0) > 0) state = MAIN_MENU;
 			state_countdown -= elapsed_time;
@@ -280,11 +322,7 @@ int main()
 		{
 			Transformation t{350,350,0,0,0,0};
 			xy2.setTransformation(t);
-			xy2.printText(Point(-30,+20),1,1,"1 Start",false,fast_straight,fast_rounded);
-			xy2.printText(Point(-30,+10),1,1,"2 HiScores",false,fast_straight,fast_rounded);
-			xy2.printText(Point(-30, 0),1,1,"3 Options",false,fast_straight,fast_rounded);
-			xy2.printText(Point(-30,-10),1,1,"4-6 Demos",false,fast_straight,fast_rounded);
-			xy2.printText(Point(-30,-20),1,1,"9 Stats",false,fast_straight,fast_rounded);
+			for (const CompiledText& text : main_menu) { text.draw(); }
 			xy2.resetTransformation();
 
 			int c = getchar_timeout_us(0);
@@ -309,8 +347,22 @@ int main()
 			case '6':	// Lissajous
 				state = LISSAJOUS_DEMO;
 				continue;
+			case '0':	// 3D wireframe
+				state = WIREFRAME_DEMO;
+				continue;
 			case '9':	// show stats
-				//TODO
+				Flash::printFlashDataStats();
+				continue;
+			case '7':	// toggle trace log, print it when stopped, decode on the host
+				trace_enabled = !trace_enabled;
+				printf("trace %s\n", trace_enabled ? "on" : "off");
+				if (!trace_enabled) trace_drain();
+				continue;
+			case '8':	// dump recording of last game for replay on the host
+				recorder.print();
+				continue;
+			case 'b':	// math kernel benchmarks
+				runMathBenchmarks();
 				continue;
 			case '@':	// reboot to BOOTSEL mode (USB)
 				reset_usb_boot(1<<25,0);
@@ -342,6 +394,14 @@ int main()
 			if (getchar_timeout_us(0) > 0) { state = MAIN_MENU; }
 			continue;
 		}
+		case WIREFRAME_DEMO:
+		{
+			xy2.resetTransformation(); rad += pi/180; if (rad>pi) rad -= 2*pi;
+
+			drawWireframe (w, rad, fast_straight);
+			if (getchar_timeout_us(0) > 0) { state = MAIN_MENU; }
+			continue;
+		}
 		case LASEROIDS_GAME:
 		{
 			int c = getchar_timeout_us(0);
@@ -491,7 +551,12 @@ int main()
 					xy2.suspend();
 					uint err = Flash::writeFlashData(&hiscores);
 					xy2.resume();
-					if (err) printf("writing hiscores to flash failed: %u\n", err);
+					if (err == Flash::OUT_OF_SPACE && Flash::gcPending())
+					{
+						hiscores_unsaved = true;
+						printf("hiscore will be written after the garbage collection\n");
+					}
+					else if (err) printf("writing hiscores to flash failed: %u\n", err);
 					else printf("hiscore written to flash\n");
 					state = LASEROIDS_ANIMATION;
 					state_countdown = FLOAT(4.0);
@@ -64,6 +64,11 @@ constexpr uint LASER_JUMP_DELAY = 20;	// after jump
 #define XY2_IMPLEMENT_ANALOGUE_CLOCK_DEMO
 #define XY2_IMPLEMENT_CHECKER_BOARD_DEMO
 #define XY2_IMPLEMENT_LISSAJOUS_DEMO
+#define XY2_IMPLEMENT_WIREFRAME_DEMO
+
+
+// Trace log: 0 = off, 1 = frames and waits, 2 = also objects
+#define TRACE_LEVEL 1
 
 
 // ADC settings
@@ -9,6 +9,9 @@
 #include "cdefs.h"
 
 
+uint32 random_state = 1;
+
+
 static int32 parseInteger(const char* bu, uint& i, bool& delta, bool& valid)
 {
 	int vz = 1;
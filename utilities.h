@@ -9,7 +9,7 @@
 #include "standard_types.h"
 #include "settings.h"
 #include <pico/stdlib.h>
-#include <stdlib.h>			// rand()
+#include <stdlib.h>
 
 
 extern int32 parseInteger(const char* bu, uint& i, int32 min, int32 dflt, int32 max);
@@ -22,13 +22,33 @@ inline Z map_range (T v, U min1, V max1, Z min2, Z max2)
 }
 
 
+// Pseudo random numbers:
+// xorshift32 generates the same sequence on all platforms, while rand() depends on the C library.
+// => a recorded game can be replayed from it's seed on the host.
+
+extern uint32 random_state;
+
+inline void srand32 (uint32 seed)
+{
+	random_state = seed ? seed : 0x2545f491u;	// must not be 0
+}
+
+inline uint32 rand32 ()
+{
+	uint32 x = random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return random_state = x;
+}
+
 inline uint rand (uint max)	// --> [0 .. max]
 {
 	uint mask = 0xffffffffu >> __builtin_clz(max);
 
 	for(;;)
 	{
-		uint n = uint(rand()) & mask;
+		uint n = rand32() & mask;
 		if (n <= max) return n;
 	}
 }
@@ -40,7 +60,7 @@ inline int rand (int min, int max)	// --> [min .. max]
 
 inline FLOAT rand (FLOAT max)
 {
-	return FLOAT(rand()) * max / FLOAT(RAND_MAX);
+	return FLOAT(rand32() >> 8) * max / FLOAT(1<<24);
 }
 
 inline FLOAT rand (FLOAT min, FLOAT max)
@@ -0,0 +1,162 @@
+// Copyright (c) 2021 Mathema GmbH
+// SPDX-License-Identifier: BSD-3-Clause
+// Author: Günter Woigk (Kio!)
+// Copyright (c) 2021 kio@little-bat.de
+// BSD 2-clause license
+
+#pragma once
+#include "VectorFont.h"
+
+
+/*	Thin Font:
+
+	a light single stroke font for scoreboards and menus:
+	most glyphs are a single stroke, some lines are drawn twice to avoid a jump.
+	same format as vt_vector_font.h, the kerning masks are not used.
+	only ' ' to 'Z': lowercase letters are printed as uppercase.
+*/
+
+
+#define L	127	// straight line
+#define R	126	// rounded line
+#define E	125	// end. E must be lowest
+
+
+constexpr signed char vt_thin_font_data[] =
+{
+// space
+	0,0, L, 2,0, E,
+// !
+	0,0, L, 0,6, 0,2, L, 0,1, 0,0, E,
+// "
+	0,0, L, 0,6, 0,4, L, 2,4, 2,6, E,
+// #
+	0,0, L, 1,1, 1,5, L, 3,5, 3,1, L, 4,2, 0,2, L, 0,4, 4,4, E,
+// $
+	0,0, L, 3,5, 0,5, 0,3, 3,3, 3,1, 0,1, L, 1,0, 1,6, E,
+// %
+	0,0, L, 0,0, 3,6, L, 0,6, 0,5, L, 3,1, 3,0, E,
+// &
+	0,0, R, 3,0, 0,4, 0,5, 1,6, 2,5, 0,2, 0,1, 1,0, 2,0, 3,2, E,
+// '
+	0,0, L, 0,6, 0,4, E,
+// (
+	0,0, R, 1,6, 0,4, 0,2, 1,0, E,
+// )
+	0,0, R, 0,6, 1,4, 1,2, 0,0, E,
+// *
+	0,0, L, 1,1, 1,5, L, 0,4, 2,2, L, 0,2, 2,4, E,
+// +
+	0,0, L, 1,1, 1,5, L, 0,3, 2,3, E,
+// ,
+	0,0, L, 1,1, 0,-1, E,
+// -
+	0,0, L, 0,3, 2,3, E,
+// .
+	0,0, L, 0,0, 0,1, E,
+// /
+	0,0, L, 0,0, 3,6, E,
+// 0
+	0,0, L, 0,0, 0,6, 3,6, 3,0, 0,0, E,
+// 1
+	0,0, L, 0,5, 1,6, 1,0, E,
+// 2
+	0,0, L, 0,6, 3,6, 3,3, 0,3, 0,0, 3,0, E,
+// 3
+	0,0, L, 0,6, 3,6, 3,3, 1,3, 3,3, 3,0, 0,0, E,
+// 4
+	0,0, L, 2,0, 2,6, 0,2, 3,2, E,
+// 5
+	0,0, L, 3,6, 0,6, 0,3, 3,3, 3,0, 0,0, E,
+// 6
+	0,0, L, 3,6, 0,6, 0,0, 3,0, 3,3, 0,3, E,
+// 7
+	0,0, L, 0,6, 3,6, 1,0, E,
+// 8
+	0,0, L, 0,3, 0,6, 3,6, 3,0, 0,0, 0,3, 3,3, E,
+// 9
+	0,0, L, 3,3, 0,3, 0,6, 3,6, 3,0, 0,0, E,
+// :
+	0,0, L, 0,5, 0,4, L, 0,2, 0,1, E,
+// ;
+	0,0, L, 0,5, 0,4, L, 0,2, 0,-1, E,
+// <
+	0,0, L, 3,6, 0,3, 3,0, E,
+// =
+	0,0, L, 0,4, 3,4, L, 3,2, 0,2, E,
+// >
+	0,0, L, 0,6, 3,3, 0,0, E,
+// ?
+	0,0, L, 0,5, 1,6, 2,6, 3,5, 3,4, 1,3, 1,2, L, 1,1, 1,0, E,
+// @
+	0,0, R, 2,2, 2,4, 1,4, 1,2, 3,2, 3,5, 2,6, 1,6, 0,5, 0,1, 1,0, 3,0, E,
+// A
+	0,0, L, 0,0, 0,4, 2,6, 4,4, 4,0, L, 0,2, 4,2, E,
+// B
+	0,0, L, 0,0, 0,6, 2,6, 3,5, 3,4, 2,3, 0,3, 2,3, 3,2, 3,1, 2,0, 0,0, E,
+// C
+	0,0, L, 3,6, 0,6, 0,0, 3,0, E,
+// D
+	0,0, L, 0,0, 0,6, 2,6, 3,5, 3,1, 2,0, 0,0, E,
+// E
+	0,0, L, 3,6, 0,6, 0,3, 2,3, 0,3, 0,0, 3,0, E,
+// F
+	0,0, L, 3,6, 0,6, 0,3, 2,3, 0,3, 0,0, E,
+// G
+	0,0, L, 3,6, 0,6, 0,0, 3,0, 3,3, 1,3, E,
+// H
+	0,0, L, 0,6, 0,0, 0,3, 3,3, 3,6, 3,0, E,
+// I
+	0,0, L, 0,0, 0,6, E,
+// J
+	0,0, L, 0,2, 0,0, 3,0, 3,6, E,
+// K
+	0,0, L, 0,0, 0,6, L, 3,6, 0,3, 3,0, E,
+// L
+	0,0, L, 0,6, 0,0, 3,0, E,
+// M
+	0,0, L, 0,0, 0,6, 2,3, 4,6, 4,0, E,
+// N
+	0,0, L, 0,0, 0,6, 3,0, 3,6, E,
+// O
+	0,0, R, 1,0, 0,1, 0,5, 1,6, 2,6, 3,5, 3,1, 2,0, 1,0, E,
+// P
+	0,0, L, 0,0, 0,6, 3,6, 3,3, 0,3, E,
+// Q
+	0,0, R, 1,0, 0,1, 0,5, 1,6, 2,6, 3,5, 3,1, 2,0, 1,0, L, 2,1, 3,0, E,
+// R
+	0,0, L, 0,0, 0,6, 3,6, 3,3, 0,3, 3,0, E,
+// S
+	0,0, R, 3,5, 2,6, 1,6, 0,5, 0,4, 3,2, 3,1, 2,0, 1,0, 0,1, E,
+// T
+	0,0, L, 0,6, 4,6, L, 2,6, 2,0, E,
+// U
+	0,0, L, 0,6, 0,0, 3,0, 3,6, E,
+// V
+	0,0, L, 0,6, 2,0, 4,6, E,
+// W
+	0,0, L, 0,6, 1,0, 2,4, 3,0, 4,6, E,
+// X
+	0,0, L, 0,0, 3,6, L, 0,6, 3,0, E,
+// Y
+	0,0, L, 0,6, 2,3, 2,0, L, 4,6, 2,3, E,
+// Z
+	0,0, L, 0,6, 3,6, 0,0, 3,0, E
+};
+
+
+// kerning pairs, sorted:
+
+constexpr VtKerning vt_thin_font_kerning[] =
+{
+	{'7','.',-1,0},
+	{'F','.',-1,0},
+	{'L','T',-1,0},
+	{'L','V',-1,0},
+	{'L','W',-1,0},
+	{'L','Y',-1,0},
+	{'P','.',-1,0},
+	{'T','.',-1,0},
+	{'V','.',-1,0},
+	{'Y','.',-1,0},
+};
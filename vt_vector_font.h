@@ -42,7 +42,7 @@
 #define E	125	// end. E must be lowest
 
 
-signed char vt_font_data[] =
+constexpr signed char vt_font_data[] =
 {
 // Leerzeichen
 	0x00, 0x00,